@@ -12,109 +12,321 @@
 
 #include "EEconfig.h"
 #include <EEPROM.h>
+#include <crc8.h>
+
+// Store being flushed (served by the EEPROM-ready interrupt)
+static EEconfig *flusher = nullptr;
+
+#ifdef ARDUINO_ARCH_AVR
+static void readyIrq(bool on)
+{
+    uint8_t sreg = SREG;
+    cli();
+    if(on) {
+        EECR |= _BV(EERIE);
+    } else {
+        EECR &= ~_BV(EERIE);
+    }
+    SREG = sreg;
+}
+
+ISR(EE_READY_vect)
+{
+    if(!flusher || !flusher->flushStep()) EECR &= ~_BV(EERIE);
+}
+#endif
+
+uint8_t EEconfig::
+readByte(uint16_t pos)
+{
+#ifdef ARDUINO_ARCH_AVR
+    // Hold off the flush: EEAR can't be touched while a write is in progress
+    bool on = (EECR & _BV(EERIE));
+    if(on) readyIrq(false);
+    uint8_t v = EEPROM.read(pos);   // (waits for a write in progress)
+    if(on) readyIrq(true);
+    return v;
+#else
+    return EEPROM.read(pos);
+#endif
+}
+
+void EEconfig::
+updateByte(uint16_t pos, uint8_t val)
+{
+#ifdef ARDUINO_ARCH_AVR
+    bool on = (EECR & _BV(EERIE));
+    if(on) readyIrq(false);
+    EEPROM.update(pos, val);
+    if(on) readyIrq(true);
+#else
+    EEPROM.update(pos, val);
+#endif
+}
 
 EEconfig::
-EEconfig(void): base(0), size(0), currpos(0), blksize(0)
+EEconfig(void): base(0), size(0), currpos(0), slotsize(0)
 {}
 
 EEconfig::
-EEconfig(uint16_t CfgSize, uint16_t EESize, uint16_t EEStart)
+EEconfig(uint8_t SlotSize, uint16_t EESize, uint16_t EEStart)
 : base(EEStart), size(0), currpos(0)
 {
-    init(CfgSize, EESize, EEStart);
+    init(SlotSize, EESize, EEStart);
 }
 
-uint16_t EEconfig::
-seekStart(void)
+uint8_t EEconfig::
+seqAt(uint8_t n)
 {
-    currpos = base;
-    // while((eeprom_read_byte((uint8_t*)currpos) == 0xFF) && seekNext());
-    while((EEPROM.read(currpos) == 0xFF) && seekNext());
-    return currpos;
+    return EEPROM.read(slotPos(n));
 }
 
 bool EEconfig::
-seekNext(void)
+checkSlot(uint8_t n)
 {
-    bool res = true;
-    currpos += blksize; 
-    if((currpos + blksize) >= (base + size)) {
-        currpos = base;
-        res = false;
+    uint16_t pos = slotPos(n);
+    uint8_t  len = EEPROM.read(pos + 2);
+    if(len > slotsize - Overhead) return false;
+    uint8_t  crc = 0;
+    for(uint8_t i = 0; i < len + 3; i++) {
+        crc = crc8_update(crc, EEPROM.read(pos + i));
     }
-    return res;
+    return (crc == EEPROM.read(pos + 3 + len));
 }
 
-bool
-EEconfig::isValid(void)
+void EEconfig::
+mount(void)
 {
-    return (EEPROM.read(currpos) == VALID);
+    valid   = false;
+    curr    = nslots - 1;   // Next write goes to slot 0
+    currpos = base;
+
+    // The run starts at slot 0; if its SEQ is erased, a save into it was
+    // cut off on the commit (after a full round), and the run of the
+    // previous round starts at slot 1
+    uint8_t st = 0;
+    uint8_t s0 = seqAt(0);
+    if(s0 == ERASED) {
+        if(nslots < 2) return;
+        st = 1;
+        s0 = seqAt(1);
+        if(s0 == ERASED) return;
+    }
+
+    // Find the last slot of the run s0, s0+1, ... from slot <st>:
+    // slot <i> is in the run iff seq(i) == s0 + i - st (mod SEQ_MOD)
+    uint8_t lo = st;
+    uint8_t hi = nslots - 1;
+    while(lo < hi) {
+        uint8_t mid = (uint8_t)((lo + hi + 1) >> 1);
+        if(seqAt(mid) == (uint8_t)((s0 + mid - st) % SEQ_MOD)) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    if(checkSlot(lo)) {
+        curr = lo;
+    } else {
+        // Current record damaged: try the one saved before it
+        uint8_t prev = (lo ? lo : nslots) - 1;
+        uint8_t ps   = seqAt(prev);
+        if(ps != (uint8_t)((seqAt(lo) + SEQ_MOD - 1) % SEQ_MOD)) return;
+        if(!checkSlot(prev)) return;
+        curr = prev;
+    }
+    seq     = seqAt(curr);
+    currpos = slotPos(curr);
+    valid   = true;
+    // Load the image, which serves read()
+    uint8_t n = EEPROM.read(currpos + 2) + Overhead;
+    for(uint8_t i = 0; i < n; i++) {
+        img[i] = EEPROM.read(currpos + i);
+    }
 }
 
 void EEconfig::
-init(uint16_t CfgSize, uint16_t EESize, uint16_t EEStart)
+init(uint8_t SlotSize, uint16_t EESize, uint16_t EEStart)
 {
     size = 0;   // Assume not inited until it is
-    if((CfgSize > EESize-1)
-    || (CfgSize == 0)
-    || (EESize == 0)) return;
-    base   = EEStart;
-    size    = EESize;
-    blksize = CfgSize + 1;  // Account for "valid/invalid" marker
-    
-    seekStart();
-}
-
-uint8_t  
-EEconfig::write(uint8_t *CfgData)
-{
-    if(!isInited()) return 0;
-    if(isValid()) {
-        // eeprom_write_byte((uint8_t*)currpos, ERASED); // void current record
-        EEPROM.write(currpos, ERASED); // void current record
-        // Serial.print(F("Write ERASED at: ")); Serial.println(currpos);
-        seekNext();
+    if((SlotSize <= Overhead)
+    || (SlotSize > MaxSlot)
+    || (EESize < SlotSize)) return;
+    abortFlush();
+    staged   = false;
+    base     = EEStart;
+    size     = EESize;
+    slotsize = SlotSize;
+    nslots   = (uint8_t)((EESize / SlotSize < SEQ_MOD - 1) ? EESize / SlotSize : SEQ_MOD - 1);
+
+    mount();
+}
+
+uint8_t
+EEconfig::version(void)
+{
+    return isValid() ? img[1] : 0;
+}
+
+uint8_t
+EEconfig::write(const uint8_t *CfgData, uint8_t len, uint8_t ver)
+{
+    if(!isInited() || len > slotsize - Overhead) return 0;
+
+    abortFlush();
+    img[1] = ver;
+    img[2] = len;
+    memcpy(&img[3], CfgData, len);
+    staged  = true;
+    stageTS = millis();
+    return len;
+}
+
+uint8_t
+EEconfig::read(uint8_t *CfgData, uint8_t maxlen)
+{
+    if(!isInited() || !isValid()) return 0;
+
+    uint8_t len = img[2];
+    memcpy(CfgData, &img[3], (len < maxlen) ? len : maxlen);
+    return len;
+}
+
+bool EEconfig::
+sameAsCurrent(void)
+{
+    if(!valid) return false;
+    for(uint8_t i = 1; i < img[2] + 3; i++) {
+        if(EEPROM.read(currpos + i) != img[i]) return false;
+    }
+    return true;
+}
+
+void EEconfig::
+startFlush(void)
+{
+    wrCnt   = 0;
+    skipCnt = 0;
+    staged  = false;
+    if(sameAsCurrent()) return;
+
+    uint8_t s;
+    if(valid) {
+        fslot = (uint8_t)((curr + 1) % nslots);
+        s     = (uint8_t)((seq + 1) % SEQ_MOD);
+        fclr  = nslots;
+    } else {
+        // No valid record: stale SEQs of the other slots are cleared
+        // first (in background too), so that none can be mistaken for
+        // part of the new run
+        fslot = 0;
+        s     = 0;
+        fclr  = 1;
+        for(uint8_t n = 1; n < nslots; n++) {
+            if(seqAt(n) != ERASED) wrCnt++;
+        }
     }
-    // eeprom_write_byte((uint8_t*)currpos, VALID); // mark valid record
-    EEPROM.write(currpos, VALID); // mark valid record
-    // Serial.print(F("Write VALID at: ")); Serial.println(currpos);
-    // AVR EEPROM is byte-oriented, so no harm to erase/write cycles
-    // in writing single bytes in a loop
-    // eeprom_write_block(CfgData, (uint8_t*)(currpos+1), blksize-1);
-    for(uint8_t i = 1; i < blksize; i++) {
-        EEPROM.write((currpos + i), CfgData[i-1]);
-        // Serial.print(F("Write data: ")); Serial.print(CfgData[i-1]);
-        // Serial.print(F(" at: ")); Serial.println(currpos + i);
+    uint8_t  len = img[2];
+    uint16_t pos = slotPos(fslot);
+    img[0] = s;
+    img[len + 3] = crc8(img, len + 3);
+
+    // Mark bytes that differ from the slot content; SEQ always does
+    // (it is written last, as commit)
+    memset(dirty, 0, sizeof(dirty));
+    wrCnt++;
+    for(uint8_t i = 1; i < len + Overhead; i++) {
+        if(EEPROM.read(pos + i) != img[i]) {
+            dirty[i >> 3] |= (uint8_t)(1 << (i & 7));
+            wrCnt++;
+        } else {
+            skipCnt++;
+        }
     }
-    return blksize-1;
+    fi       = 1;
+    flusher  = this;
+    flushing = true;
+#ifdef ARDUINO_ARCH_AVR
+    readyIrq(true);
+#endif
 }
 
-uint8_t  
-EEconfig::read(uint8_t *CfgData)
+bool EEconfig::
+flushStep(void)
 {
-    if(!isInited() || !isValid()) return 0;
+    if(!flushing) return false;
 
-    // eeprom_read_block(CfgData, (uint8_t*)(currpos+1), blksize-1);
-    for(uint8_t i = 1; i < blksize; i++) {
-        CfgData[i-1] = EEPROM.read(currpos + i);
+    while(fclr < nslots && seqAt(fclr) == ERASED) fclr++;
+    if(fclr < nslots) {
+        EEPROM.write(slotPos(fclr), ERASED);
+        fclr++;
+        return true;
+    }
+    uint16_t pos = slotPos(fslot);
+    uint8_t  n   = img[2] + Overhead;
+    while(fi < n && !(dirty[fi >> 3] & (1 << (fi & 7)))) fi++;
+    if(fi < n) {
+        EEPROM.write(pos + fi, img[fi]);
+        fi++;
+        return true;
+    }
+    // Commit
+    EEPROM.write(pos, img[0]);
+    curr     = fslot;
+    seq      = img[0];
+    currpos  = pos;
+    valid    = true;
+    flushing = false;
+    return false;
+}
+
+void EEconfig::
+abortFlush(void)
+{
+#ifdef ARDUINO_ARCH_AVR
+    readyIrq(false);
+#endif
+    // SEQ not written yet: slot is left uncommitted
+    flushing = false;
+}
+
+void
+EEconfig::poll(void)
+{
+#ifndef ARDUINO_ARCH_AVR
+    if(flushing) {
+        flushStep();
+        return;
     }
-    return blksize-1;
+#endif
+    if(staged && !flushing && (millis() - stageTS) >= QuietMs) startFlush();
 }
 
-uint8_t  
-EEconfig::getByte(uint16_t pos)
+void
+EEconfig::sync(void)
 {
-    return EEPROM.read(pos); 
+    if(staged && !flushing) startFlush();
+#ifdef ARDUINO_ARCH_AVR
+    // Take the flush over from the interrupt (writes wait for the one
+    // in progress)
+    readyIrq(false);
+#endif
+    while(flushStep());
 }
 
-void  
+void
 EEconfig::erase(void)
 {
     if(!isInited()) return;
+    abortFlush();
+    staged  = false;
     for(uint16_t i = base; i < base+size; i++) {
-        EEPROM.write(i, 0xFF);
+        EEPROM.update(i, ERASED);
     }
     currpos = base;
+    curr    = nslots - 1;
+    valid   = false;
 }
 
 // END EEconfig.cpp
@@ -15,43 +15,125 @@
 #include <stdint.h>
 #include <Arduino.h>
 
+// The area is split into fixed-size slots, written round-robin (wear
+// leveling); each save goes to the slot after the current one.
+// Slot layout:
+//   SEQ  VER  LEN  DATA[LEN]  CRC
+// SEQ is a sequence counter (0..254, wrapping; 0xFF = erased slot), VER
+// the caller's layout version, CRC a CRC-8 (see crc8.h) over SEQ, VER, LEN
+// and DATA. SEQ is written last, so a save interrupted by a power loss
+// leaves the previous record as the current one.
+// Sequence numbers increase by one from slot to slot, up to the current
+// record; mount finds it by a binary search for the end of that run
+// (O(log n) reads), then checks its CRC (falling back to the record
+// before it). A save into slot 0 cut off on the commit leaves its SEQ
+// erased: the run is then searched from slot 1.
+//
+// Writes are deferred: write() only updates a RAM image of the record,
+// which also serves read(). Once no write() has come for QuietMs, poll()
+// compares the image with the target slot, and the bytes that differ
+// (marked in a dirty bitmap) are written in background, one per
+// EEPROM-ready interrupt (on AVR; one per poll() call elsewhere). A burst
+// of writes thus costs a single record, and a write() with nothing
+// changed costs none. A write() during a flush aborts it (SEQ is not
+// written yet, so the slot is not committed) and restarts the quiet time.
+// With no valid record, the flush of the first one also clears the stale
+// SEQs of the other slots, before writing slot 0. sync() runs what is
+// left of a flush from the caller, with the interrupt off.
+// While a flush runs, other EEPROM accesses must go through readByte() /
+// updateByte().
+
 class EEconfig
 {
+public:
+
+    /// Bytes added to the payload in each slot
+    static const uint8_t Overhead = 4;
+    /// Largest slot (size of the RAM image)
+    static const uint8_t MaxSlot  = 96;
+    /// Time without write() before the record is flushed
+    static const uint16_t QuietMs = 500;
+
 private:
 
     static const uint8_t ERASED = 0xFF;
-    static const uint8_t VALID  = 0x00;
-    
+    static const uint8_t SEQ_MOD = 0xFF;    // SEQ never takes the ERASED value
+
     uint16_t    base = 0;
     uint16_t    size = 0;
     uint16_t    currpos;
-    uint8_t     blksize = 0;
+    uint8_t     slotsize = 0;
+    uint8_t     nslots = 0;
+    uint8_t     curr;           // Current slot
+    uint8_t     seq;            // SEQ of current record
+    bool        valid = false;  // Current record in EEPROM (and in img)
+
+    // Write-behind state
+    uint8_t     img[MaxSlot];   // Image of the latest record
+    uint8_t     dirty[MaxSlot/8];   // Bytes of img to write (bitmap)
+    bool        staged = false; // img newer than EEPROM, flush not started
+    volatile bool flushing = false;
+    uint8_t     fi;             // Next byte to check for flush
+    uint8_t     fslot;          // Slot being flushed
+    uint8_t     fclr;           // Next slot to clear the SEQ of (first record)
+    unsigned long stageTS;
 
-    uint16_t    seekStart(void);
-    bool        seekNext(void);
+    uint16_t    slotPos(uint8_t n)  { return base + (uint16_t)n * slotsize; }
+    uint8_t     seqAt(uint8_t n);
+    bool        checkSlot(uint8_t n);
+    void        mount(void);
+    void        startFlush(void);
+    void        abortFlush(void);
+    bool        sameAsCurrent(void);
+
+    uint16_t    wrCnt = 0;
+    uint16_t    skipCnt = 0;
 
 public:
 
     EEconfig(void);
-    EEconfig(uint16_t CfgSize, uint16_t EESize, uint16_t EEStart = 0);
-    
-    // Remember that 1 byte overhead is added to the payload size.
-    // This could be spared if the first byte of a valid payload is guaranteed
-    // never to be a 0xFF (or any other given value defined as ERASED);
-    // in this case, the marker is part of the payload and 'VALID' const is no 
-    // longer required (as are the offsets for the marker byte added to the counters).
-
-    void    init(uint16_t CfgSize, uint16_t EESize, uint16_t EEStart = 0);
+    EEconfig(uint8_t SlotSize, uint16_t EESize, uint16_t EEStart = 0);
+
+    void    init(uint8_t SlotSize, uint16_t EESize, uint16_t EEStart = 0);
     bool    isInited(void) { return (size != 0); }
-    bool    isValid(void);
+    bool    isValid(void)  { return valid || staged || flushing; }
+
+    /// Layout version of the latest record
+    uint8_t version(void);
+
+    /// Save <len> bytes as a new record of layout <ver> (deferred);
+    /// returns bytes saved (0 if it doesn't fit)
+    uint8_t write(const uint8_t *CfgData, uint8_t len, uint8_t ver);
+
+    /// Read up to <maxlen> bytes of the latest record;
+    /// returns the record length (0 if none)
+    uint8_t read(uint8_t *CfgData, uint8_t maxlen);
+
+    /// Start the flush after the quiet time; call from main loop
+    void    poll(void);
+
+    /// Flush now, and wait for completion
+    void    sync(void);
+
+    /// True if the latest record is not fully in EEPROM yet
+    bool    pending(void)       { return staged || flushing; }
+
+    /// EEPROM bytes written / skipped (unchanged) by the last flush
+    uint16_t lastWrites(void)   { return wrCnt; }
+    uint16_t lastSkips(void)    { return skipCnt; }
+
+    /// Write the next dirty byte; returns false when done.
+    /// (Internal: called from the EEPROM-ready interrupt)
+    bool    flushStep(void);
 
-    uint8_t write(uint8_t *CfgData);
-    uint8_t read(uint8_t *CfgData);
+    /// EEPROM access that is safe while a flush runs
+    static uint8_t readByte(uint16_t pos);
+    static void    updateByte(uint16_t pos, uint8_t val);
 
     // Debug only:
     uint16_t getCurrPos(void)   { return currpos; };
     uint16_t getBase(void)      { return base; };
-    uint8_t  getByte(uint16_t pos);
+    uint8_t  getByte(uint16_t pos) { return readByte(pos); }
     void     erase(void);
 
 };
@@ -81,3 +81,51 @@ public:
   }
 };
 
+// Division-free fixed-point variant, for integer inputs on small MCUs.
+// The weight of new values is 1/2^Shift (e.g. Shift=2 -> 25%), so the
+// update only takes shifts and adds:
+//   Acc += New - Acc/2^Shift      (Acc = Current * 2^Shift)
+// The generic template above instead needs two multiplications and two
+// divisions by 100 per sample, and with T=int (16 bit on AVR) the term
+// 100*m_WeightNew*New overflows for 10-bit ADC values.
+// <Acc> must hold (max input) << Shift, plus rounding: use Fits() to check
+// at compile time, e.g. ExpFilterQ<2, uint16_t, uint16_t> for 0..1023.
+template<uint8_t Shift, class T = int, class Acc = int32_t> class ExpFilterQ
+{
+  static_assert((Shift >= 1) && (Shift < 8*sizeof(Acc)), "Invalid ExpFilterQ shift");
+  static_assert(sizeof(Acc) <= 4, "ExpFilterQ accumulator is 32 bit max");
+
+  // Current filtered value, scaled by 2^Shift
+  Acc m_Acc;
+
+public:
+  ExpFilterQ(void)
+    : m_Acc(0)
+  { }
+
+  explicit ExpFilterQ(T Initial)
+    : m_Acc((Acc)Initial << Shift)
+  { }
+
+  // True if inputs up to <MaxIn> can't overflow the accumulator
+  static constexpr bool Fits(uint32_t MaxIn)
+  {
+    return (((uint64_t)MaxIn << Shift) + ((uint64_t)1 << Shift) - 1)
+            <= (((uint64_t)1 << (8*sizeof(Acc) - ((Acc)-1 < 0 ? 1 : 0))) - 1);
+  }
+
+  void Filter(T New)
+  {
+    // Rounded, so the output settles on the input at both ends of the range
+    m_Acc = m_Acc - ((m_Acc + ((Acc)1 << (Shift-1))) >> Shift) + (Acc)New;
+  }
+
+  uint8_t GetShift() const { return Shift; }
+
+  T Current() const { return (T)((m_Acc + ((Acc)1 << (Shift-1))) >> Shift); }
+
+  void SetCurrent(T NewValue)
+  {
+    m_Acc = (Acc)NewValue << Shift;
+  }
+};
@@ -0,0 +1,168 @@
+// =======================================================================
+// @file        InFilter.h
+//
+// @details     Input filter policies for 10-bit (ADC) values
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __INFILTER__H__
+#define __INFILTER__H__
+
+#include <stdint.h>
+#include <ExpFilter.h>
+#include <average_acc.h>
+
+// Every policy exposes:
+//   uint16_t apply(uint16_t v)  - feed a new sample, return filtered value
+//   void setShift(uint8_t s)    - set weight of the exponential stage
+//                                 (1/2^s; ignored by other stages)
+// Policies are plain templates: only the ones actually selected get
+// instantiated, so unused filters cost neither flash nor RAM, and
+// stateless stages take no room inside a FilterChain.
+
+/// Pass-through
+class FilterNone
+{
+public:
+    uint16_t apply(uint16_t v) { return v; }
+    void setShift(uint8_t) {}
+};
+
+/// Exponential filter, weight of new values 1/2^s; <Shift> is the
+/// initial s, which can be changed at runtime (1..MaxShift).
+/// Same update as ExpFilterQ, with a runtime shift.
+template<uint8_t Shift>
+class FilterExp
+{
+public:
+    static constexpr uint8_t MaxShift = 6;
+
+private:
+    static_assert(ExpFilterQ<MaxShift, uint16_t, uint16_t>::Fits(1023),
+                  "FilterExp overflows on 10-bit values");
+    static_assert((Shift >= 1) && (Shift <= MaxShift), "Invalid FilterExp shift");
+    uint16_t acc;
+    uint8_t  sh;
+
+    uint16_t current(void) { return (uint16_t)((acc + (1U << (sh-1))) >> sh); }
+
+public:
+    FilterExp(void) : acc(0), sh(Shift) {}
+
+    uint16_t apply(uint16_t v)
+    {
+        acc = acc - current() + v;
+        return current();
+    }
+
+    void setShift(uint8_t s)
+    {
+        if(s < 1 || s > MaxShift) return;
+        // Keep the current output
+        uint16_t c = current();
+        sh  = s;
+        acc = (uint16_t)(c << s);
+    }
+};
+
+/// Box (moving average) filter; see AverageAcc for <Log2Len>
+template<uint8_t Log2Len>
+class FilterBox
+{
+    AverageAcc acc;
+
+public:
+    FilterBox(void) : acc(Log2Len) {}
+    uint16_t apply(uint16_t v) { acc.addVal(v); return acc.average(); }
+    void setShift(uint8_t) {}
+};
+
+/// Median of the last 3 or 5 samples (kills isolated spikes)
+template<uint8_t N>
+class FilterMedian
+{
+    static_assert((N == 3) || (N == 5), "FilterMedian supports 3 or 5 samples");
+    uint16_t buf[N];
+    uint8_t  pos;
+
+    static void sort2(uint16_t &a, uint16_t &b)
+    {
+        if(a > b) { uint16_t t = a; a = b; b = t; }
+    }
+
+public:
+    FilterMedian(void) : buf(), pos(0) {}
+
+    uint16_t apply(uint16_t v)
+    {
+        buf[pos] = v;
+        if(++pos >= N) pos = 0;
+        uint16_t a = buf[0], b = buf[1], c = buf[2];
+        if(N == 5) {
+            // Partial sorting network: only the middle element is needed
+            uint16_t d = buf[N > 3 ? 3 : 0], e = buf[N > 4 ? 4 : 0];
+            sort2(a, b); sort2(d, e);
+            sort2(a, d); sort2(b, e);   // a = min of 4, e = max of 4: discard
+            sort2(b, c); sort2(c, d);
+            sort2(b, c);
+            return c;
+        }
+        sort2(a, b); sort2(b, c); sort2(a, b);
+        return b;
+    }
+
+    void setShift(uint8_t) {}
+};
+
+/// Deadband: output only follows input moves larger than <Band>.
+/// Ends of the range (0 and <MaxIn>) are always passed, so full off/on
+/// can be reached whatever the last value.
+template<uint8_t Band, uint16_t MaxIn = 1023>
+class FilterHyst
+{
+    uint16_t out;
+
+public:
+    FilterHyst(void) : out(0) {}
+
+    uint16_t apply(uint16_t v)
+    {
+        uint16_t d = (v > out ? v - out : out - v);
+        if((d > Band) || (v == 0) || (v >= MaxIn)) out = v;
+        return out;
+    }
+
+    void setShift(uint8_t) {}
+};
+
+/// Stages applied in order, e.g. FilterChain<FilterMedian<3>, FilterExp<2>>
+template<class... Fs> class FilterChain;
+
+template<>
+class FilterChain<>
+{
+public:
+    uint16_t apply(uint16_t v) { return v; }
+    void setShift(uint8_t) {}
+};
+
+template<class F, class... Rest>
+class FilterChain<F, Rest...> : private F, private FilterChain<Rest...>
+{
+public:
+    uint16_t apply(uint16_t v)
+    {
+        return FilterChain<Rest...>::apply(F::apply(v));
+    }
+
+    void setShift(uint8_t s)
+    {
+        F::setShift(s);
+        FilterChain<Rest...>::setShift(s);
+    }
+};
+
+#endif  //!__INFILTER__H__
@@ -0,0 +1,78 @@
+// =======================================================================
+// @file        RingBuf.h
+//
+// @details     Lock-free single-producer / single-consumer ring buffer
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __RINGBUF__H__
+#define __RINGBUF__H__
+
+#include <stdint.h>
+
+/// Ring buffer meant to be filled from an ISR and drained from the main loop
+/// (or the other way around), without disabling interrupts.
+/// Each index is written by one side only and is a single byte, so its
+/// reads and writes are atomic on AVR; the compiler barrier makes sure the
+/// payload is in place before the index publishing it is updated.
+/// <N> must be a power of 2 (max 128); one slot is kept empty, so the
+/// usable capacity is N-1.
+
+template<class T, uint8_t N>
+class RingBuf
+{
+    static_assert((N != 0) && ((N & (N-1)) == 0) && (N <= 128),
+                  "RingBuf size must be a power of 2 <= 128");
+
+private:
+    T                   buf[N];
+    volatile uint8_t    head;   // Written by producer only
+    volatile uint8_t    tail;   // Written by consumer only
+    volatile uint8_t    drops;  // Items rejected because the ring was full
+
+    static void barrier(void) { __asm__ __volatile__("" ::: "memory"); }
+
+public:
+    RingBuf(void) : head(0), tail(0), drops(0) {}
+
+    /// Producer side: returns false (and counts a drop) if full
+    bool push(const T &val)
+    {
+        uint8_t h = head;
+        uint8_t n = (h + 1) & (N - 1);
+        if(n == tail) {
+            if(drops != 0xFF) drops = drops + 1;
+            return false;
+        }
+        buf[h] = val;
+        barrier();
+        head = n;
+        return true;
+    }
+
+    /// Consumer side: returns false if empty
+    bool pop(T &val)
+    {
+        uint8_t t = tail;
+        if(t == head) return false;
+        val = buf[t];
+        barrier();
+        tail = (t + 1) & (N - 1);
+        return true;
+    }
+
+    bool    isEmpty(void)   { return (head == tail); }
+    uint8_t count(void)     { return ((head - tail) & (N - 1)); }
+
+    /// Drop counter saturates at 255; clear it after reading if needed
+    uint8_t dropped(void)   { return drops; }
+    void    clearDropped(void) { drops = 0; }
+
+    /// Consumer side only
+    void    flush(void)     { tail = head; }
+};
+
+#endif  //!__RINGBUF__H__
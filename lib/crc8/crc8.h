@@ -0,0 +1,43 @@
+// =======================================================================
+// @file        crc8.h
+//
+// @details     CRC-8 (poly 0x07, init 0x00 - "CRC-8/SMBUS")
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __CRC8__H__
+#define __CRC8__H__
+
+#include <stdint.h>
+
+#ifdef ARDUINO_ARCH_AVR
+#include <util/crc16.h>
+#endif
+
+/// Update <crc> with byte <data>.
+/// Same algorithm as avr-libc's _crc8_ccitt_update(), which is used on AVR
+/// (hand-optimized asm); check value for "123456789" is 0xF4.
+inline uint8_t crc8_update(uint8_t crc, uint8_t data)
+{
+#ifdef ARDUINO_ARCH_AVR
+    return _crc8_ccitt_update(crc, data);
+#else
+    crc ^= data;
+    for(uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+#endif
+}
+
+/// CRC of a whole buffer
+inline uint8_t crc8(const uint8_t *buf, uint8_t len, uint8_t crc = 0)
+{
+    while(len--) crc = crc8_update(crc, *buf++);
+    return crc;
+}
+
+#endif  //!__CRC8__H__
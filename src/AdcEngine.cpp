@@ -0,0 +1,111 @@
+// =======================================================================
+// @file        AdcEngine.cpp
+//
+// @project     NanoPWM
+// @details     Interrupt-driven, non-blocking ADC with channel multiplexing
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "AdcEngine.h"
+#include "main.h"
+
+#ifdef  USE_ADC_ISR
+
+namespace AdcEngine
+{
+    uint8_t             admux[ADC_CH];
+    uint16_t            vals[ADC_CH][2];
+    volatile uint8_t    pub[ADC_CH];    // bit 0 = published slot; increments on every result
+    uint8_t             seen[ADC_CH];
+    uint8_t             cur  = 0;
+    volatile bool       busy = false;
+    bool                cont = false;
+    ConvHook            onConv = nullptr;
+
+    static uint8_t muxFor(uint8_t pin)
+    {
+        // Same mapping as analogRead(); reference is AVcc (DEFAULT)
+#if defined(__AVR_ATmega32U4__)
+        if(pin >= 18) pin -= 18;
+        pin = analogPinToChannel(pin);
+#else
+        if(pin >= 14) pin -= 14;
+#endif
+        return (uint8_t)(_BV(REFS0) | (pin & 0x0F));
+    }
+
+    static inline void startConv(uint8_t ch)
+    {
+#if defined(MUX5)
+        ADCSRB = (ADCSRB & ~_BV(MUX5)) | ((admux[ch] & 0x08) ? _BV(MUX5) : 0);
+#endif
+        ADMUX   = admux[ch] & ~0x08;
+        ADCSRA |= _BV(ADSC);
+    }
+
+    void begin(bool continuous, ConvHook hook)
+    {
+        ADCSRA &= ~_BV(ADIE);
+        for(uint8_t ch = 0; ch < ADC_CH; ch++) {
+            admux[ch] = muxFor(chan[ch].ADCpin);
+            pub[ch]   = 0;
+            seen[ch]  = 0;
+        }
+        cont   = continuous;
+        onConv = hook;
+        cur    = 0;
+        // Prescaler is left as set by the core (125 kHz ADC clock @ 16 MHz)
+        ADCSRA |= _BV(ADIF);    // clear stale flag
+        ADCSRA |= _BV(ADIE);
+        busy = cont;
+        if(cont) startConv(0);
+    }
+
+    bool startSweep(void)
+    {
+        if(busy) return false;
+        busy = true;
+        cur  = 0;
+        startConv(0);
+        return true;
+    }
+
+    bool get(uint8_t ch, uint16_t &val)
+    {
+        uint8_t p = pub[ch];
+        val = vals[ch][p & 0x01];
+        bool fresh = (p != seen[ch]);
+        seen[ch] = p;
+        return fresh;
+    }
+}
+
+ISR(ADC_vect)
+{
+    using namespace AdcEngine;
+    uint8_t  ch = cur;
+    uint16_t v  = ADC;
+
+    // Write the slot not currently published, then publish it
+    uint8_t p = pub[ch] + 1;
+    vals[ch][p & 0x01] = v;
+    __asm__ __volatile__("" ::: "memory");
+    pub[ch] = p;
+
+    uint8_t nx = ch + 1;
+    if(nx >= ADC_CH) {
+        nx = 0;
+        if(!cont) busy = false;
+    }
+    cur = nx;
+    if(busy) startConv(nx);
+
+    if(onConv) onConv(ch, v);
+}
+
+#endif  //USE_ADC_ISR
+
+// end AdcEngine.cpp
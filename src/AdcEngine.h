@@ -0,0 +1,48 @@
+// =======================================================================
+// @file        AdcEngine.h
+//
+// @project     NanoPWM
+// @details     Interrupt-driven, non-blocking ADC with channel multiplexing
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __ADCENGINE__H__
+#define __ADCENGINE__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Conversions are chained from the ADC-complete interrupt: the ISR stores
+// the result, rotates the mux to the next channel's ADCpin and starts the
+// next conversion, so no CPU time is spent waiting (analogRead() spins for
+// ~110us per conversion).
+// Results are published in a per-channel double buffer: the ISR always
+// writes the slot the reader is NOT looking at, then flips a one-byte
+// index, so the main loop can fetch a 16-bit value without disabling
+// interrupts.
+//
+// Two operating modes:
+// - continuous: the ring of channels is converted over and over;
+// - sweep:      each startSweep() converts all channels once (used by the
+//               Sampler to pace sampling from the tick).
+
+namespace AdcEngine
+{
+    typedef void (*ConvHook)(uint8_t ch, uint16_t val);
+
+    /// Reads ADC pins from chan[]: call after channels have been set.
+    /// With <hook> != null, it is called (in ISR context) for every result.
+    void    begin(bool continuous, ConvHook hook = nullptr);
+
+    /// Sweep mode only; returns false if the previous sweep is still running
+    bool    startSweep(void);
+
+    /// Latest value for channel <ch>; returns true if it is new since the
+    /// last call for the same channel.
+    bool    get(uint8_t ch, uint16_t &val);
+}
+
+#endif  //!__ADCENGINE__H__
@@ -0,0 +1,152 @@
+// =======================================================================
+// @file        Baud.cpp
+//
+// @project     NanoPWM
+// @details     Serial baud rate selection and auto-baud detection
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Baud.h"
+#include "main.h"
+
+// The serial interface is not available when DMX takes over the UART
+#ifndef DMX_ON_UART0
+
+// Auto-baud needs the RX pin of the hardware UART (D0 = PD0)
+#if defined(ARDUINO_ARCH_AVR) && !defined(PROMICRO)
+#define AUTOBAUD_HW
+#endif
+
+namespace Baud
+{
+    const uint32_t Rates[NumRates] PROGMEM = {
+        19200, 38400, 57600, 115200, 250000, 500000, 1000000
+    };
+
+    uint8_t sel_ = Default;
+
+    uint32_t rate(uint8_t sel)
+    {
+        if(sel >= NumRates) sel = Default;
+        return pgm_read_dword(&Rates[sel]);
+    }
+
+#ifdef AUTOBAUD_HW
+    // Time one char, in CPU cycles from start bit to stop bit.
+    // Returns 0 on timeout, or if the edges are not those of a 0x55 (9
+    // intervals of one bit each). Runs with interrupts off; <ovf> counts
+    // Timer1 overflows (4ms each) left before giving up: it runs down
+    // whatever the line does, as a call never lasts a Timer1 period.
+    static uint16_t timeSync(uint16_t &ovf)
+    {
+        // Cap for a char: 9 bits at ~10% below the slowest rate
+        const uint16_t MaxCycles = (uint16_t)((F_CPU * 10UL) / 19200UL);
+        // Edge detection granularity: one pass of the polling loop, and
+        // the store between edges
+        const uint16_t PollCycles = 16;
+
+        // Wait for start bit (also when the line is held low: the
+        // overflow is checked before, on each call)
+        do {
+            if(TIFR1 & _BV(TOV1)) {
+                TIFR1 = _BV(TOV1);
+                if(--ovf == 0) return 0;
+            }
+        } while(PIND & _BV(PD0));
+
+        // 9 edges: bits 0..7 alternate, stop bit rises
+        uint16_t t[10];
+        uint8_t  lvl = 0;
+        t[0] = TCNT1;
+        for(uint8_t e = 1; e < 10; e++) {
+            while((PIND & _BV(PD0)) == lvl) {
+                if((uint16_t)(TCNT1 - t[0]) > MaxCycles) return 0;
+            }
+            t[e] = TCNT1;
+            lvl ^= _BV(PD0);
+        }
+
+        uint16_t dt  = t[9] - t[0];
+        uint16_t bit = dt / 9;
+        uint16_t tol = bit / 2 + PollCycles;
+        for(uint8_t e = 1; e < 10; e++) {
+            uint16_t iv = t[e] - t[e-1];
+            if(iv + tol < bit || iv > bit + tol) return 0;
+        }
+        return dt;
+    }
+
+    // Returns the table index matching the rate measured, or AUTO if none
+    static uint8_t detect(void)
+    {
+        uint8_t res  = AUTO;
+        uint8_t sreg = SREG;
+        uint8_t tA   = TCCR1A;
+        uint8_t tB   = TCCR1B;
+        uint8_t tI   = TIMSK1;
+
+        pinMode(0, INPUT_PULLUP);
+        cli();
+        // Timer1: normal mode, no prescaler
+        TIMSK1 = 0;
+        TCCR1A = 0;
+        TCCR1B = _BV(CS10);
+        TIFR1  = _BV(TOV1);
+
+        uint16_t ovf = (uint16_t)((AutoWindowMs * 1000UL) / (65536000000UL / F_CPU));
+        while(res == AUTO && ovf != 0) {
+            uint16_t dt = timeSync(ovf);
+            if(dt == 0) continue;
+            uint32_t est = (F_CPU * 9UL) / dt;
+            // Accept if within 1/8 of a table rate
+            for(uint8_t i = 0; i < NumRates; i++) {
+                uint32_t r = rate(i);
+                if(est > r - (r >> 3) && est < r + (r >> 3)) {
+                    res = i;
+                    break;
+                }
+            }
+        }
+
+        TCCR1B = tB;
+        TCCR1A = tA;
+        TCNT1  = 0;
+        TIMSK1 = tI;
+        SREG   = sreg;
+        return res;
+    }
+#endif
+
+    void begin(uint8_t sel)
+    {
+        if(sel == AUTO) {
+#ifdef AUTOBAUD_HW
+            sel = detect();
+#endif
+        }
+        if(sel >= NumRates) sel = Default;
+        sel_ = sel;
+        Serial.begin(rate(sel));
+    }
+
+    void change(uint8_t sel)
+    {
+        if(sel >= NumRates) return;
+        Serial.flush();
+        Serial.end();
+        sel_ = sel;
+        Serial.begin(rate(sel));
+    }
+
+    uint8_t current(void)
+    {
+        return sel_;
+    }
+}
+
+#endif  //!DMX_ON_UART0
+
+// end Baud.cpp
@@ -0,0 +1,55 @@
+// =======================================================================
+// @file        Baud.h
+//
+// @project     NanoPWM
+// @details     Serial baud rate selection and auto-baud detection
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __BAUD__H__
+#define __BAUD__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// The baud rate is stored in config as an index into a table of standard
+// rates (see rate()); 19200 is the default, and the one restored by a
+// factory reset.
+//
+// With AUTO selected, at boot the board waits (up to AutoWindowMs) for a
+// 'U' (0x55) sync char from the host. For 0x55 every bit is a transition,
+// and the time from the falling edge of the start bit to the rising edge
+// of the stop bit is exactly 9 bit times; this is timed with Timer1 at
+// F_CPU, then snapped to the nearest rate in the table. The sync char is
+// consumed. If no sync char is recognized in time, the default rate is
+// used. Timer1 is borrowed for the purpose (its setup is restored
+// afterwards): begin() must be called before the outputs on Timer1
+// (D9/D10) are set up, as they would stop while waiting.
+//
+// At 16 MHz 250k, 500k and 1M are exact; 115200 is within 2.1%.
+// On the ProMicro, Serial is the USB CDC port and the rate is irrelevant.
+
+namespace Baud
+{
+    constexpr uint8_t  NumRates     = 7;
+    constexpr uint8_t  Default      = 0;
+    constexpr uint8_t  AUTO         = 9;
+    constexpr uint16_t AutoWindowMs = 3000;
+
+    /// Baud rate for table index <sel> (Default rate if out of range)
+    uint32_t rate(uint8_t sel);
+
+    /// Open Serial with setting <sel> (table index or AUTO)
+    void     begin(uint8_t sel);
+
+    /// Change rate on the fly (pending output is sent at the old rate)
+    void     change(uint8_t sel);
+
+    /// Table index of the rate in use
+    uint8_t  current(void);
+}
+
+#endif  //!__BAUD__H__
@@ -0,0 +1,203 @@
+// =======================================================================
+// @file        BinCmd.cpp
+//
+// @project     NanoPWM
+// @details     Binary framed serial protocol (setpoint streaming)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "BinCmd.h"
+#include "main.h"
+#include "crc8.h"
+#include "Latch.h"
+#include "Rs485.h"
+
+// The serial interface is not available when DMX takes over the UART
+#ifndef DMX_ON_UART0
+
+namespace BinCmd
+{
+    enum State : uint8_t { IDLE = 0, TYPE, LEN, DATA, CRC };
+
+    State       state   = IDLE;
+    uint8_t     type;
+    uint8_t     len;
+    uint8_t     bi;
+    uint8_t     crc;
+    uint8_t     buf[MaxLen];
+    bool        reply;              // Reply allowed for current frame
+    uint16_t    sliceStart;         // Own slice offset in a T_SLICE frame
+    uint8_t     sliceLen;
+
+    uint8_t     ackMode = ACK_EACH;
+    uint8_t     batchCnt = 0;
+    uint16_t    goodCnt = 0;
+    uint16_t    badCnt  = 0;
+
+    static bool runFrame(void)
+    {
+        if(type != T_SLICE && len > MaxLen) return false;
+
+        switch(type) {
+            case T_VALUES:
+                if(len == 0 || len > MAX_CH) return false;
+                for(uint8_t i = 0; i < len; i++) {
+                    Latch::stage(i, buf[i]);
+                }
+                Latch::commit();
+                return true;
+
+            case T_STAGE:
+            {
+                if(len < 2) return false;
+                uint16_t mask = buf[0] | ((uint16_t)buf[1] << 8);
+                uint8_t  n    = 0;
+                for(uint16_t m = mask; m; m &= (m - 1)) n++;
+                if((mask >> MAX_CH) || (len != 2 + n)) return false;
+                uint8_t *v = &buf[2];
+                for(uint8_t ch = 0; mask; ch++, mask >>= 1) {
+                    if(mask & 1) Latch::stage(ch, *v++);
+                }
+                return true;
+            }
+
+            case T_LATCH:
+                if(len != 0) return false;
+                Latch::commit();
+                return true;
+
+            case T_ADDR:
+                if(len < 2 || buf[1] == T_ADDR || buf[1] == T_SLICE) return false;
+                if(buf[0] != nodeAddr && buf[0] != BROADCAST) return true;
+                reply = (buf[0] == nodeAddr);
+                // Unwrap the inner frame
+                type = buf[1];
+                len -= 2;
+                for(uint8_t i = 0; i < len; i++) buf[i] = buf[i+2];
+                return runFrame();
+
+            case T_SLICE:
+                if(len < 2 || buf[1] == 0) return false;
+                // Frame not covering this node's slice: nothing to do
+                if(sliceStart == 0xFFFF || len < 2 + sliceStart + sliceLen) {
+                    return true;
+                }
+                for(uint8_t i = 0; i < sliceLen; i++) {
+                    Latch::stage(i, buf[2+i]);
+                }
+                Latch::commit();
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    static void endFrame(bool ok)
+    {
+        uint8_t r = 0;
+
+        state = IDLE;
+        if(ok) {
+            goodCnt++;
+            if(ackMode == ACK_EACH) {
+                r = ACK;
+            } else
+            if(ackMode == ACK_BATCH && ++batchCnt >= AckBatch) {
+                batchCnt = 0;
+                r = ACK;
+            }
+        } else {
+            badCnt++;
+            if(ackMode != ACK_NONE) r = NAK;
+        }
+        if(r && reply) {
+            Rs485::txEnable();
+            Serial.write(r);
+        }
+    }
+
+    bool feed(uint8_t c)
+    {
+        switch(state) {
+            case IDLE:
+                if(c != SYNC) return false;
+                crc   = 0;
+                reply = (nodeAddr == 0);
+                state = TYPE;
+                break;
+
+            case TYPE:
+                type  = c;
+                crc   = crc8_update(crc, c);
+                state = LEN;
+                break;
+
+            case LEN:
+                len   = c;
+                crc   = crc8_update(crc, c);
+                bi    = 0;
+                state = (len ? DATA : CRC);
+                break;
+
+            case DATA:
+                crc   = crc8_update(crc, c);
+                if(type == T_SLICE && bi >= 2) {
+                    // Keep only this node's slice
+                    uint16_t j = bi - 2;
+                    if(j == 0) {
+                        uint8_t k  = buf[1];
+                        sliceLen   = (k < MAX_CH) ? k : MAX_CH;
+                        sliceStart = (nodeAddr != 0 && nodeAddr >= buf[0]) ?
+                                     (uint16_t)(nodeAddr - buf[0]) * k : 0xFFFF;
+                    }
+                    if(j >= sliceStart && j < sliceStart + sliceLen) {
+                        buf[2 + j - sliceStart] = c;
+                    }
+                } else
+                if(bi < MaxLen) {
+                    buf[bi] = c;
+                }
+                if(++bi >= len) state = CRC;
+                break;
+
+            case CRC:
+                endFrame((c == crc) && runFrame());
+                break;
+        }
+        return true;
+    }
+
+    void reset(void)
+    {
+        state = IDLE;
+    }
+
+    void setAckMode(uint8_t mode)
+    {
+        ackMode  = mode;
+        batchCnt = 0;
+    }
+
+    uint8_t getAckMode(void)
+    {
+        return ackMode;
+    }
+
+    void printStats(void)
+    {
+        Serial.print(F("Bin frames: OK "));
+        Serial.print(goodCnt);
+        Serial.print(F(" / ERR "));
+        Serial.print(badCnt);
+        Serial.print(F(" / Ack mode "));
+        Serial.println(ackMode);
+    }
+}
+
+#endif  //!DMX_ON_UART0
+
+// end BinCmd.cpp
@@ -0,0 +1,82 @@
+// =======================================================================
+// @file        BinCmd.h
+//
+// @project     NanoPWM
+// @details     Binary framed serial protocol (setpoint streaming)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __BINCMD__H__
+#define __BINCMD__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Frame layout:
+//   SYNC  TYPE  LEN  PAYLOAD[LEN]  CRC
+// SYNC is 0xAA; being outside the ASCII range, it can't be confused with
+// a text command (text and binary frames may be freely interleaved).
+// CRC is CRC-8/SMBUS (see crc8.h) over TYPE, LEN and PAYLOAD.
+//
+// Frame types:
+//   0x01  Values: PAYLOAD = setpoints of channels 0..LEN-1 (LEN <= MAX_CH)
+//         Channels are switched to external source, as with "V", and
+//         updated all together (see Latch.h).
+//   0x02  Stage: PAYLOAD = channel mask (2 bytes, LSB first), then one
+//         value for each channel in the mask, in ascending order.
+//         Values are staged only; several frames can be combined.
+//   0x03  Latch: (LEN = 0) apply all staged values together
+//   0x10  Addressed: PAYLOAD = node address, then TYPE and PAYLOAD of
+//         an inner frame (values, stage or latch), run only by the node
+//         with that address, or by all nodes for address 0xFF (broadcast).
+//   0x11  Slice: PAYLOAD = first node address, K, then K values for each
+//         node from the first one on. Each node takes (up to MAX_CH of)
+//         its own K values, and applies them at once at the end of the
+//         frame, so one frame updates all nodes together. LEN may exceed
+//         MaxLen here (up to 255): only the node's own slice is stored.
+//
+// Replies (single byte, see setAckMode()):
+//   0x06 (ACK) frame executed, 0x15 (NAK) CRC or format error.
+// On a bus (node address set, see nodeAddr), a node only replies to
+// frames addressed to it individually: broadcast, slice and plain frames
+// are executed silently, and bad frames are just counted.
+
+namespace BinCmd
+{
+    constexpr uint8_t SYNC      = 0xAA;
+    constexpr uint8_t ACK       = 0x06;
+    constexpr uint8_t NAK       = 0x15;
+    constexpr uint8_t MaxLen    = 16;   // Max payload length
+
+    constexpr uint8_t T_VALUES  = 0x01;
+    constexpr uint8_t T_STAGE   = 0x02;
+    constexpr uint8_t T_LATCH   = 0x03;
+    constexpr uint8_t T_ADDR    = 0x10;
+    constexpr uint8_t T_SLICE   = 0x11;
+    constexpr uint8_t BROADCAST = 0xFF;
+
+    enum AckMode : uint8_t {
+        ACK_NONE  = 0,      // No replies at all
+        ACK_EACH  = 1,      // ACK/NAK for every frame
+        ACK_BATCH = 2,      // One ACK every AckBatch good frames; NAK at once
+    };
+    constexpr uint8_t AckBatch  = 16;
+
+    /// Feed a received byte. Returns false if the byte is not part of a
+    /// binary frame (i.e. no frame in progress and byte is not SYNC).
+    bool    feed(uint8_t c);
+
+    /// Drop any partially received frame
+    void    reset(void);
+
+    void    setAckMode(uint8_t mode);
+    uint8_t getAckMode(void);
+
+    /// Print frame counters (good / bad)
+    void    printStats(void);
+}
+
+#endif  //!__BINCMD__H__
@@ -0,0 +1,80 @@
+// =======================================================================
+// @file        Budget.cpp
+//
+// @project     NanoPWM
+// @details     Global power budget: proportional output limiting
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Budget.h"
+#include "main.h"
+
+namespace Budget
+{
+    uint16_t    budget  = 0;        // In load units (1/16 * 0.1 A)
+    uint16_t    total   = 0;        // Sum of channel loads
+    uint16_t    k       = ONE;      // Scale factor
+    uint16_t    applied = ONE;      // Factor last applied to all channels
+
+    // Loads are at most 255*16 per channel
+    static_assert((uint32_t)MAX_CH * 255 * 16 <= 0xFFFF, "Load sum overflows");
+
+    static void normalize(void)
+    {
+        if(budget == 0 || total <= budget) {
+            k = ONE;
+        } else {
+            // budget < total: fits in Q15 below 1.0
+            k = (uint16_t)(((uint32_t)budget << 15) / total);
+        }
+    }
+
+    bool setLimit(uint16_t dA)
+    {
+        if(dA > MaxBudget) return false;
+        budget = dA << 4;
+        normalize();
+        return true;
+    }
+
+    uint16_t limit(void)
+    {
+        return budget >> 4;
+    }
+
+    void update(uint16_t oldLoad, uint16_t newLoad)
+    {
+        total = total - oldLoad + newLoad;
+        if(budget) normalize();
+    }
+
+    uint16_t scale(uint16_t o)
+    {
+        if(k == ONE) return o;
+        return (uint16_t)(((uint32_t)o * k) >> 15);
+    }
+
+    uint16_t factor(void)
+    {
+        return k;
+    }
+
+    uint16_t load(void)
+    {
+        return total;
+    }
+
+    void run(void)
+    {
+        if(k == applied) return;
+        applied = k;
+        // Loads depend on requested values only, so this doesn't change
+        // the sum (or the factor) again; unchanged outputs are skipped
+        for(uint8_t ch = 0; ch < MAX_CH; ch++) chan[ch].refresh();
+    }
+}
+
+// end Budget.cpp
@@ -0,0 +1,55 @@
+// =======================================================================
+// @file        Budget.h
+//
+// @project     NanoPWM
+// @details     Global power budget: proportional output limiting
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __BUDGET__H__
+#define __BUDGET__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Each channel has a max current (drawn at 100% duty, see Channel::maxCur)
+// and contributes a load proportional to its output duty, after the
+// brightness curve. The loads are kept as a running sum, updated only
+// when a channel output changes (Channel::prepVal()).
+// When the sum exceeds the budget, all outputs are scaled by the same
+// factor budget/sum (Q15, computed once per change of the sum), so that
+// the total stays within budget and the channels keep their ratios.
+// A channel change applies the new factor to that channel at once; run()
+// re-applies it to the others.
+//
+// Currents are in units of 0.1 A; loads in 1/16 of that.
+// A budget of 0 (default) disables limiting; a channel with max current
+// 0 is not counted.
+
+namespace Budget
+{
+    constexpr uint16_t ONE       = 0x8000;  // Scale 1.0 (Q15)
+    constexpr uint16_t MaxBudget = 2550;    // 255 A
+
+    /// Set the global budget (0.1 A units; 0 = no limit)
+    bool    setLimit(uint16_t dA);
+    uint16_t limit(void);
+
+    /// Replace a channel's contribution <oldLoad> with <newLoad>
+    void    update(uint16_t oldLoad, uint16_t newLoad);
+
+    /// Apply the current scale factor to output value <o>
+    uint16_t scale(uint16_t o);
+
+    /// Current scale factor (Q15) and total requested load (1/16 * 0.1 A)
+    uint16_t factor(void);
+    uint16_t load(void);
+
+    /// Re-apply a changed factor to all channels; call from main loop
+    void    run(void);
+}
+
+#endif  //!__BUDGET__H__
@@ -11,11 +11,29 @@
 // =======================================================================
 
 #include "Channel.h"
+#include "Budget.h"
+
+// Saturating count. With USE_I2C the counters are also read from the TWI
+// ISR (I2cRegs), so both bytes are updated with interrupts off.
+static inline void countUp(uint16_t &cnt)
+{
+    if(cnt == 0xFFFF) return;
+#ifdef USE_I2C
+    uint8_t sreg = SREG;
+    cli();
+    cnt++;
+    SREG = sreg;
+#else
+    cnt++;
+#endif
+}
 
 Channel::
 Channel(void)
-: ADCpin(0xFF), PWMpin(0xFF), PWMval(0x00),
-internal(true), reverse(false), LEDcorrect(true), active(true)
+: ADCpin(0xFF), PWMpin(0xFF), PWMval(0x00), weight(DefWeight),
+internal(true), reverse(false), LEDcorrect(true), active(true),
+curve(Curves::CIE), lut(nullptr), maxCur(0), load(0),
+outVal(0), outForce(true), writeCnt(0), skipCnt(0)
 {}
 
 uint8_t Channel::
@@ -29,7 +47,7 @@ pack(uint8_t* dst)
     if(active)     flags |= 0x08;
     // *dst++ = ADCpin;    // Unused here: fixed value
     // *dst++ = PWMpin;    // Unused here: fixed value
-    // *dst++ = PWMval;    // Unused here: not saved
+    // *dst++ = PWMval;    // Saved separately
     *dst++ = flags; n++;
     return n; // MUST be equal to cfgSize!
 }
@@ -41,7 +59,7 @@ unpack(uint8_t* src)
     uint8_t n = 0;
     // ADCpin = *src++;  // Unused here: fixed value
     // PWMpin = *src++;  // Unused here: fixed value
-    // PWMval = *src++;  // Unused here: not saved
+    // PWMval = *src++;  // Saved separately
     flags  = *src++; n++;
     LEDcorrect = ((flags & 0x01) != 0); 
     reverse    = ((flags & 0x02) != 0); 
@@ -50,34 +68,73 @@ unpack(uint8_t* src)
     return n; // MUST be equal to cfgSize!
 }
 
+bool Channel::
+setWeight(uint8_t w)
+{
+    if(w < 1 || w > MaxWeight) return false;
+    weight = w;
+    filter.setShift(w);
+    return true;
+}
+
+bool Channel::
+setCurve(uint8_t c)
+{
+    bool ok;
+    if(c == curve) return true;
+    if(c >= Curves::NumCurves) return false;
+    // Release first, so that a channel that is the only user of a table
+    // can switch it to another curve (e.g. with a single table)
+    Curves::release(curve);
+    const Curves::Lut *t = Curves::acquire(c, ok);
+    if(!ok) {
+        // No table free: the old one is still in use by others, so it is
+        // still there to take back
+        lut = Curves::acquire(curve, ok);
+        return false;
+    }
+    curve = c;
+    lut   = t;
+    return true;
+}
+
 void Channel::
-set(uint8_t Apin, uint8_t Ppin)
+set(uint8_t Apin, uint8_t Ppin, uint8_t bits)
 {
     ADCpin = Apin;
     PWMpin = Ppin;
-    // acc.setLength(accSize);
-    filter.SetWeight(ExpWeight);
-    pinMode(Apin, INPUT); 
+    outForce = true;
+    if(Apin != 0xFF) pinMode(Apin, INPUT);
+    out.begin(Ppin, bits);
 }
 
 uint8_t Channel::
-fetchInVal(void)
+procInVal(uint16_t aval)
 {
-    uint16_t aval = analogRead(ADCpin);
-    uint16_t res  = 0;
+    uint16_t res;
     
     // Always read ADC anyway, even if value is forced from Serial
-    // acc.addVal(aval);
-    filter.Filter(aval);
-    res = ADCval();
-    
-    res = (aval+2) >> 2; //DEBUG
+    res = (filter.apply(aval) + 2) >> 2;
     if(res > 255) res = 255;
     return (uint8_t)res;
 }
 
-void  Channel::
-setVal(uint8_t val)
+// Power budget stage: account the load of output value <o> (duty, before
+// reversal), and return it scaled to the budget
+uint16_t Channel::
+limit(uint16_t o)
+{
+    uint16_t d = (out.bits() == 8) ? PWMtables::linear((uint8_t)o, 12) : o;
+    uint16_t l = (uint16_t)(((uint32_t)maxCur * d) >> 8);
+    if(l != load) {
+        Budget::update(load, l);
+        load = l;
+    }
+    return Budget::scale(o);
+}
+
+bool  Channel::
+prepVal(uint8_t val)
 {   
     PWMval = val;
     if(!active) val = 0;
@@ -88,16 +145,40 @@ setVal(uint8_t val)
     // applying "LEDcorrect" does not only fail to improve the brightness progression,
     // but it actually makes it worse!
 
-    if(LEDcorrect) val = pgm_read_byte(PWMtables::TAB_CIE_8 + val);
-    if(reverse) val = (255-val);
-    if(val == 0) {
-        digitalWrite(PWMpin, 0);
-    } else
-    if(val == 255) {
-        digitalWrite(PWMpin, 1);
+    uint16_t o;
+    if(out.bits() == 8) {
+        if(LEDcorrect) {
+            if(curve == Curves::CIE) {
+                val = pgm_read_byte(PWMtables::TAB_CIE_8 + val);
+            } else if(lut) {
+                val = (uint8_t)(lut[val] >> (Curves::LutBits - 8));
+            }
+        }
+        o = limit(val);
+        if(reverse) o = (255-o);
     } else {
-        analogWrite(PWMpin, val);
+        // 12-bit output (high-res timer, or dithered)
+        if(LEDcorrect && curve == Curves::CIE) {
+            o = pgm_read_word(PWMtables::TAB_CIE_12 + val);
+        } else if(LEDcorrect && lut) {
+            o = lut[val];
+            if(Curves::LutBits == 8) o = PWMtables::linear((uint8_t)o, 12);
+        } else {
+            o = PWMtables::linear(val, 12);
+        }
+        o = limit(o);
+        if(reverse) o = (4095-o);
+    }
+
+    // Pin setup is slow: skip it if output is unchanged
+    if((o == outVal) && !outForce) {
+        countUp(skipCnt);
+        return false;
     }
+    outVal   = o;
+    outForce = false;
+    countUp(writeCnt);
+    return true;
 }
 
 // end channel.cpp
\ No newline at end of file
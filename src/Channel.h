@@ -15,41 +15,96 @@
 
 #include <stdint.h>
 #include <Arduino.h>
-#include <avr\pgmspace.h>
 #include "PWMtables.h"
-// #include <average_acc.h>
-#include <ExpFilter.h>
+#include "PwmOut.h"
+#include "Curves.h"
+#include <InFilter.h>
 
 class Channel
 {
-    static constexpr uint8_t ExpWeight = 30;
+    // Default exp filter weight is 1/2^ExpShift (25%)
+    static constexpr uint8_t ExpShift = 2;
+    // Deadband (in ADC counts) for the hysteresis stage
+    static constexpr uint8_t HystBand = 2;
 
 public:
+    // Input filter, selected at build time:
+    //   IN_FILTER_RAW      no filtering
+    //   IN_FILTER_EXP      exponential
+    //   IN_FILTER_BOX      moving average
+    //   IN_FILTER_MEDIAN   median of 5 + deadband
+    //   (default)          median of 3 + exponential + deadband
+#if   defined(IN_FILTER_RAW)
+    typedef FilterNone InFilter;
+#elif defined(IN_FILTER_EXP)
+    typedef FilterExp<ExpShift> InFilter;
+#elif defined(IN_FILTER_BOX)
+    typedef FilterBox<3> InFilter;
+#elif defined(IN_FILTER_MEDIAN)
+    typedef FilterChain<FilterMedian<5>, FilterHyst<HystBand> > InFilter;
+#else
+    typedef FilterChain<FilterMedian<3>, FilterExp<ExpShift>, FilterHyst<HystBand> > InFilter;
+#endif
+
+    // Weight of the exponential input stage is 1/2^weight (if any; see
+    // InFilter), settable per channel in 1..MaxWeight
+    static constexpr uint8_t MaxWeight = 6;
+    static constexpr uint8_t DefWeight = ExpShift;
+
     uint8_t          ADCpin;
     uint8_t          PWMpin;
     uint8_t          PWMval;
-    // AverageAcc  acc;
-    ExpFilter<int>   filter;
+    InFilter         filter;
+    uint8_t          weight;
     bool             internal;
     bool             reverse;
     bool             LEDcorrect;
     bool             active;
+    // Brightness curve applied if LEDcorrect (see Curves)
+    uint8_t          curve;
+    const Curves::Lut *lut;
+    // Current at 100% duty (0.1 A units; 0 = not counted), and load
+    // currently accounted for this channel (see Budget)
+    uint8_t          maxCur;
+    uint16_t         load;
 
-    static constexpr uint8_t accSize = 3;
-    static constexpr uint8_t cfgSize =
-        /* sizeof(ADCpin)+sizeof(PWMpin)+sizeof(PWMval)+ */ 1;
+    // Output actually written to the pin; a write is skipped if unchanged
+    PwmOut           out;
+    uint16_t         outVal;
+    bool             outForce;
+    uint16_t         writeCnt;
+    uint16_t         skipCnt;
+
+    // Size of the flags packed by pack(); setpoint and weight are saved
+    // separately (see saveParams())
+    static constexpr uint8_t cfgSize = 1;
 
     Channel(void);
-    uint8_t ADCval(void)
-    // { return ((acc.average() + 2) >> 2); }
-    { return ((filter.Current() + 2) >> 2); }
 
-    void    set(uint8_t Apin, uint8_t Ppin);
-    uint8_t fetchInVal(void);
-    void    setVal(uint8_t val);
+    // <Apin>:  0xFF for channels with no pot input
+    // <bits>:  output resolution requested (8, or 10..12; see PwmOut)
+    void    set(uint8_t Apin, uint8_t Ppin, uint8_t bits = 8);
+    uint8_t fetchInVal(void)        { return procInVal(analogRead(ADCpin)); }
+    uint8_t procInVal(uint16_t aval);
+    void    setVal(uint8_t val)     { if(prepVal(val)) applyVal(); }
+    // Two-step setVal() (see Latch): prepVal() computes the output value
+    // and returns true if it has to be written; applyVal() writes it.
+    bool    prepVal(uint8_t val);
+    void    applyVal(void)          { out.write(outVal); }
     uint8_t getVal(void)            { return PWMval; }
+    bool    setWeight(uint8_t w);
+    // Select curve <c> (Curves::Id); false if invalid or no table free.
+    // Does not refresh the output.
+    bool    setCurve(uint8_t c);
+    // Set max current; refresh the output afterwards
+    void    setMaxCur(uint8_t dA)   { maxCur = dA; }
+    // Re-apply current setpoint (e.g. after a change of flags)
+    void    refresh(void)           { setVal(PWMval); }
     uint8_t pack(uint8_t *dst);
     uint8_t unpack(uint8_t *src);
+
+private:
+    uint16_t limit(uint16_t o);
 };
 
 #endif //!__CHANNEL__H__
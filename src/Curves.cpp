@@ -0,0 +1,198 @@
+// =======================================================================
+// @file        Curves.cpp
+//
+// @project     NanoPWM
+// @details     Brightness curves: lookup tables generated at runtime
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Curves.h"
+#include "PWMtables.h"
+
+namespace Curves
+{
+    constexpr uint16_t LutMax   = (1U << LutBits) - 1;
+    constexpr uint8_t  NO_CURVE = 0xFF;
+
+    // Gamma exponents (Q8.8)
+    constexpr uint16_t G22 = 563;   // 2.2
+    constexpr uint16_t G28 = 717;   // 2.8
+
+    // 2^(-1/2^(k+1)) in Q16, for exp2() of the fractional bits
+    const uint16_t Exp2Frac[16] PROGMEM = {
+        46341, 55109, 60097, 62757, 64132, 64830, 65182, 65359,
+        65447, 65492, 65514, 65525, 65530, 65533, 65535, 65535,
+    };
+
+#if CURVE_TABLES > 0
+    struct Table
+    {
+        uint8_t     id;
+        uint8_t     refs;
+        Lut         tab[256];
+    };
+
+    Table   tables[CURVE_TABLES];
+    bool    inited = false;
+#endif
+
+    // Custom curve breakpoints (default: linear)
+    uint8_t px[MaxPoints] = { 255 };
+    uint8_t py[MaxPoints] = { 255 };
+    uint8_t npts = 1;
+
+    // log2(x) in Q16, x = 1..255
+    static int32_t log2q(uint8_t x)
+    {
+        int32_t  r = 0;
+        uint32_t m = x;
+        // Integer part; mantissa normalized to [1,2) in Q15
+        while(m >= 2) { m >>= 1; r += 65536L; }
+        m = (uint32_t)x << (15 - (r >> 16));
+        // Fractional part, one bit per squaring
+        for(uint16_t b = 0x8000; b; b >>= 1) {
+            m = (m * m) >> 15;
+            if(m >= 65536UL) {
+                m >>= 1;
+                r += b;
+            }
+        }
+        return r;
+    }
+
+    // 2^(-e) in Q15, e >= 0 in Q16
+    static uint16_t exp2negq(uint32_t e)
+    {
+        uint8_t  n = (uint8_t)((e >> 16) > 15 ? 16 : (e >> 16));
+        uint16_t f = (uint16_t)e;
+        uint32_t r = 32768UL;
+        for(uint8_t k = 0; k < 16; k++) {
+            if(f & (0x8000 >> k)) {
+                r = (r * pgm_read_word(&Exp2Frac[k]) + 32768UL) >> 16;
+            }
+        }
+        return (uint16_t)(r >> n);
+    }
+
+    uint16_t gamma(uint8_t x, uint16_t g88, uint16_t maxOut)
+    {
+        static int32_t lg255 = 0;
+        if(x == 0) return 0;
+        if(lg255 == 0) lg255 = log2q(255);
+        // (x/255)^g = 2^(g * (log2(x) - log2(255)))
+        // -log2(x/255) <= 8.0: fits with g up to 16.0
+        uint32_t lg = (uint32_t)(lg255 - log2q(x));
+        uint32_t e  = (lg * g88) >> 8;
+        uint32_t r  = exp2negq(e);
+        return (uint16_t)((r * maxOut + 16384UL) >> 15);
+    }
+
+#if CURVE_TABLES > 0
+    static Lut piecewise(uint8_t x)
+    {
+        uint8_t x0 = 0, y0 = 0;
+        for(uint8_t i = 0; i < npts; i++) {
+            if(x <= px[i]) {
+                uint8_t  x1  = px[i];
+                uint32_t num = ((uint32_t)y0 * (x1 - x) + (uint32_t)py[i] * (x - x0)) * LutMax;
+                uint32_t den = (uint32_t)(x1 - x0) * 255;
+                return (Lut)((num + den / 2) / den);
+            }
+            x0 = px[i];
+            y0 = py[i];
+        }
+        return (Lut)(((uint32_t)y0 * LutMax + 127) / 255);
+    }
+
+    static void generate(Table &t, uint8_t id)
+    {
+        t.id = id;
+        for(uint16_t x = 0; x < 256; x++) {
+            switch(id) {
+                case GAMMA22:   t.tab[x] = (Lut)gamma((uint8_t)x, G22, LutMax); break;
+                case GAMMA28:   t.tab[x] = (Lut)gamma((uint8_t)x, G28, LutMax); break;
+                default:        t.tab[x] = piecewise((uint8_t)x); break;
+            }
+        }
+    }
+#endif
+
+    const Lut *acquire(uint8_t id, bool &ok)
+    {
+        ok = (id < NumCurves);
+        if(!ok || id == LINEAR || id == CIE) return nullptr;
+#if CURVE_TABLES > 0
+        if(!inited) {
+            for(uint8_t i = 0; i < CURVE_TABLES; i++) tables[i].id = NO_CURVE;
+            inited = true;
+        }
+        // Already there (possibly unused, but still valid)?
+        for(uint8_t i = 0; i < CURVE_TABLES; i++) {
+            if(tables[i].id == id) {
+                tables[i].refs++;
+                return tables[i].tab;
+            }
+        }
+        for(uint8_t i = 0; i < CURVE_TABLES; i++) {
+            if(tables[i].refs == 0) {
+                generate(tables[i], id);
+                tables[i].refs = 1;
+                return tables[i].tab;
+            }
+        }
+#endif
+        ok = false;
+        return nullptr;
+    }
+
+    void release(uint8_t id)
+    {
+#if CURVE_TABLES > 0
+        if(!inited) return;
+        for(uint8_t i = 0; i < CURVE_TABLES; i++) {
+            if(tables[i].id == id && tables[i].refs) {
+                tables[i].refs--;
+                return;
+            }
+        }
+#else
+        (void)id;
+#endif
+    }
+
+    bool setPoint(uint8_t n, uint8_t x, uint8_t y)
+    {
+        if(n >= MaxPoints || n > npts) return false;
+        if(n > 0 && x <= px[n-1]) return false;
+        if(x == 0) return false;
+        px[n] = x;
+        py[n] = y;
+        npts  = n + 1;
+#if CURVE_TABLES > 0
+        if(!inited) return true;
+        for(uint8_t i = 0; i < CURVE_TABLES; i++) {
+            if(tables[i].id != CUSTOM) continue;
+            if(tables[i].refs) {
+                generate(tables[i], CUSTOM);
+            } else {
+                tables[i].id = NO_CURVE;    // Stale
+            }
+        }
+#endif
+        return true;
+    }
+
+    uint8_t getPoints(uint8_t *xy)
+    {
+        for(uint8_t i = 0; i < npts; i++) {
+            *xy++ = px[i];
+            *xy++ = py[i];
+        }
+        return npts;
+    }
+}
+
+// end Curves.cpp
@@ -0,0 +1,77 @@
+// =======================================================================
+// @file        Curves.h
+//
+// @project     NanoPWM
+// @details     Brightness curves: lookup tables generated at runtime
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __CURVES__H__
+#define __CURVES__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+#include "PwmOut.h"
+
+// A channel with LEDcorrect on maps its setpoint through one of these
+// curves; with LEDcorrect off, the curve is ignored (linear).
+// - LINEAR and CIE need no RAM: CIE uses the PROGMEM tables (PWMtables).
+// - Gamma and custom curves are generated into 256-entry tables in RAM,
+//   from a fixed-point description: gamma exponent in Q8.8, or a
+//   piecewise-linear list of breakpoints. Tables are generated when a
+//   channel first selects the curve, and shared by all channels using it.
+//   There are CURVE_TABLES of them; each takes 258 bytes, or 514 with
+//   12-bit outputs. They are opt-in (default 0: only LINEAR and CIE can be
+//   selected), and selecting a curve fails if none is free.
+// Table entries have the output resolution of the build (PWM_BITS), so the
+// lookup is a single load; 8-bit outputs in a 12-bit build drop 4 bits.
+
+#ifndef CURVE_TABLES
+#define CURVE_TABLES    0
+#endif
+
+namespace Curves
+{
+    enum Id : uint8_t {
+        LINEAR  = 0,
+        CIE     = 1,
+        GAMMA22 = 2,
+        GAMMA28 = 3,
+        CUSTOM  = 4,    // Piecewise-linear, see setPoint()
+        NumCurves
+    };
+
+#if PWM_BITS > 8
+    typedef uint16_t Lut;
+    constexpr uint8_t  LutBits   = 12;
+#else
+    typedef uint8_t  Lut;
+    constexpr uint8_t  LutBits   = 8;
+#endif
+    constexpr uint8_t  MaxPoints = 8;
+
+    /// Get the table for curve <id>, generating it if needed.
+    /// Returns null for curves with no RAM table (LINEAR, CIE); <ok> is
+    /// false if <id> is invalid or no table is free.
+    const Lut *acquire(uint8_t id, bool &ok);
+
+    /// Drop a reference taken by acquire()
+    void    release(uint8_t id);
+
+    /// Set breakpoint #n (from 0) of the custom curve, and drop the ones
+    /// after it. The curve runs from (0,0) through the breakpoints (x
+    /// strictly increasing), then stays flat; outputs in 0..255 scale.
+    /// A table in use is regenerated: refresh the channels afterwards.
+    bool    setPoint(uint8_t n, uint8_t x, uint8_t y);
+
+    /// Copy breakpoints as x,y pairs to <xy>; returns their number
+    uint8_t getPoints(uint8_t *xy);
+
+    /// Output (0..<maxOut>) of gamma <g88> (Q8.8) for input <x> (0..255)
+    uint16_t gamma(uint8_t x, uint16_t g88, uint16_t maxOut);
+}
+
+#endif  //!__CURVES__H__
@@ -0,0 +1,189 @@
+// =======================================================================
+// @file        Dmx.cpp
+//
+// @project     NanoPWM
+// @details     DMX512 receiver on a hardware UART
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Dmx.h"
+#include "main.h"
+
+#ifdef USE_DMX
+
+#ifdef DMX_ON_UART0
+    #define DMX_UCSRA   UCSR0A
+    #define DMX_UCSRB   UCSR0B
+    #define DMX_UCSRC   UCSR0C
+    #define DMX_UBRR    UBRR0
+    #define DMX_UDR     UDR0
+    #define DMX_RX_vect USART_RX_vect
+#else
+    #define DMX_UCSRA   UCSR1A
+    #define DMX_UCSRB   UCSR1B
+    #define DMX_UCSRC   UCSR1C
+    #define DMX_UBRR    UBRR1
+    #define DMX_UDR     UDR1
+    #define DMX_RX_vect USART1_RX_vect
+#endif
+// Bit positions are the same for all USARTs
+#define DMX_FE      4
+#define DMX_DOR     3
+#define DMX_U2X     1
+#define DMX_RXEN    4
+#define DMX_RXCIE   7
+#define DMX_USBS    3
+#define DMX_UCSZ0   1
+#define DMX_UCSZ1   2
+
+namespace Dmx
+{
+    enum : uint8_t { IDLE = 0, START, DATA };
+
+    // ISR state
+    volatile uint8_t    state   = IDLE;
+    uint16_t            slot;               // Number of next slot (1-based)
+    uint16_t            first   = 1;        // Window: first..last slot
+    uint16_t            last    = MAX_CH;
+
+    // Double buffer, published by <pub>; <seq> counts publications
+    uint8_t             buf[2][MAX_CH];
+    uint8_t             wr      = 0;
+    volatile uint8_t    pub     = 1;
+    volatile uint8_t    seq     = 0;
+    uint8_t             seen    = 0;
+
+    volatile uint16_t   nPackets  = 0;
+    volatile uint16_t   nIgnored  = 0;
+    volatile uint16_t   nOverruns = 0;
+
+    static void barrier(void) { __asm__ __volatile__("" ::: "memory"); }
+
+    void begin(uint16_t addr)
+    {
+        setAddress(addr);
+        uint8_t sreg = SREG;
+        cli();
+        // 250 kbaud (exact at 16 MHz), 8N2, RX only with interrupt
+        DMX_UBRR  = (uint16_t)(F_CPU / (16UL * 250000UL) - 1);
+        DMX_UCSRA = 0;
+        DMX_UCSRC = _BV(DMX_USBS) | _BV(DMX_UCSZ1) | _BV(DMX_UCSZ0);
+        DMX_UCSRB = _BV(DMX_RXEN) | _BV(DMX_RXCIE);
+        SREG = sreg;
+    }
+
+    void setAddress(uint16_t addr)
+    {
+        if(addr < 1) addr = 1;
+        if(addr > DMX_ADDR_MAX) addr = DMX_ADDR_MAX;
+        uint8_t sreg = SREG;
+        cli();
+        first = addr;
+        last  = addr + MAX_CH - 1;
+        state = IDLE;       // Wait for next break
+        SREG = sreg;
+    }
+
+    uint16_t address(void)
+    {
+        return first;
+    }
+
+    bool read(uint8_t *dst)
+    {
+        uint8_t s;
+        do {
+            s = seq;
+            if(s == seen) return false;
+            barrier();
+            const uint8_t *src = buf[pub];
+            for(uint8_t i = 0; i < MAX_CH; i++) dst[i] = src[i];
+            barrier();
+            // Retry if a new packet was published meanwhile (the buffer
+            // being copied may have been reused)
+        } while(s != seq);
+        seen = s;
+        return true;
+    }
+
+    uint16_t packets(void)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t n = nPackets;
+        SREG = sreg;
+        return n;
+    }
+
+    uint16_t ignored(void)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t n = nIgnored;
+        SREG = sreg;
+        return n;
+    }
+
+    uint16_t overruns(void)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t n = nOverruns;
+        SREG = sreg;
+        return n;
+    }
+}
+
+using namespace Dmx;
+
+ISR(DMX_RX_vect)
+{
+    uint8_t st = DMX_UCSRA;
+    uint8_t d  = DMX_UDR;
+
+    if(st & _BV(DMX_DOR)) nOverruns++;
+    if(st & _BV(DMX_FE)) {
+        // Break (or line error): a packet in progress is incomplete
+        if(state == DATA) nIgnored++;
+        state = (d == 0) ? START : IDLE;
+        return;
+    }
+
+    switch(state) {
+        case START:
+            // Only dimmer data (start code 0) is used
+            if(d == 0) {
+                slot  = 1;
+                state = DATA;
+            } else {
+                nIgnored++;
+                state = IDLE;
+            }
+            break;
+
+        case DATA:
+            if(slot >= first) {
+                buf[wr][slot - first] = d;
+                if(slot == last) {
+                    barrier();
+                    pub = wr;
+                    wr ^= 1;
+                    seq++;
+                    nPackets++;
+                    state = IDLE;
+                }
+            }
+            slot++;
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif  //USE_DMX
+
+// end Dmx.cpp
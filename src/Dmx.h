@@ -0,0 +1,53 @@
+// =======================================================================
+// @file        Dmx.h
+//
+// @project     NanoPWM
+// @details     DMX512 receiver on a hardware UART
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __DMX__H__
+#define __DMX__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// DMX512: 250 kbaud, 8N2. A packet starts with a break (line low for
+// > 88us), received by the UART as a 0x00 char with framing error; then
+// the start code (0x00 for dimmer data) and up to 512 slots.
+//
+// The whole parsing is done in the RX interrupt: the slots in the window
+// [address, address+MAX_CH) are stored directly into one half of a double
+// buffer; when the last one is received, that half is published and the
+// other one is used for the next packet. Packets with a non-zero start
+// code, or too short to cover the whole window, are ignored.
+//
+// UART used:
+//   ProMicro  USART1 (RX1 pin); Serial (USB) keeps the command interface
+//   Nano      USART0 (D0): the only UART is taken over, so the serial
+//             command interface is not available (DMX_ON_UART0)
+
+namespace Dmx
+{
+    constexpr uint16_t MaxSlots = 512;
+
+    /// Start receiving; <addr> is the first slot used (1..DMX_ADDR_MAX)
+    void     begin(uint16_t addr);
+
+    void     setAddress(uint16_t addr);
+    uint16_t address(void);
+
+    /// Copy the latest complete packet (MAX_CH values) to <dst>.
+    /// Returns false if no new packet was received since last call.
+    bool     read(uint8_t *dst);
+
+    /// Counters: packets published / packets ignored / UART overruns
+    uint16_t packets(void);
+    uint16_t ignored(void);
+    uint16_t overruns(void);
+}
+
+#endif  //!__DMX__H__
@@ -0,0 +1,123 @@
+// =======================================================================
+// @file        Fader.cpp
+//
+// @project     NanoPWM
+// @details     Non-blocking per-channel fades (transitions)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Fader.h"
+#include "main.h"
+#include "SysTick.h"
+
+namespace Fader
+{
+    constexpr uint32_t ONE = 1UL << 24;     // Phase at end of fade
+
+    struct Fade
+    {
+        uint32_t    phase;
+        uint32_t    step;       // Phase increment per tick
+        uint8_t     from;
+        uint8_t     to;
+        uint8_t     curve;
+    };
+
+    Fade        fades[MAX_CH];
+    uint16_t    mask    = 0;
+    uint8_t     lastTick;
+
+    uint16_t ease(uint16_t p, uint8_t curve)
+    {
+        uint32_t p2 = ((uint32_t)p * p) >> 16;
+        uint32_t e;
+        switch(curve) {
+            case IN:
+                return (uint16_t)p2;
+            case OUT:
+                // 1 - (1-p)^2 = 2p - p^2
+                e = ((uint32_t)p << 1) - p2;
+                break;
+            case IN_OUT:
+            {
+                // 3x^2 - 2x^3, with x = p in Q10: exact in 32 bits, so it
+                // never steps back (truncating p^2 and p^3 apart did), and
+                // still finer than the 8-bit setpoint it drives
+                uint32_t x = p >> 6;
+                e = (x * x * (3 * 1024 - 2 * x)) >> 14;
+                break;
+            }
+            default:
+                return p;
+        }
+        // With p^2 truncated, 2p - p^2 goes past 1.0 near the end
+        return (e > 0xFFFF) ? 0xFFFF : (uint16_t)e;
+    }
+
+    void start(uint16_t m, uint8_t target, uint32_t ms, uint8_t curve)
+    {
+        uint32_t ticks = (ms * 1000UL) / SysTick::TICK_US;
+
+        if(curve >= NumCurves) curve = LINEAR;
+        if(mask == 0) lastTick = SysTick::ticks();
+        for(uint8_t ch = 0; ch < MAX_CH; ch++, m >>= 1) {
+            if(!(m & 1)) continue;
+            chan[ch].internal = false;
+            if(ticks == 0) {
+                stop(ch);
+                chan[ch].setVal(target);
+                continue;
+            }
+            Fade &f = fades[ch];
+            f.from  = chan[ch].getVal();
+            f.to    = target;
+            f.curve = curve;
+            f.phase = 0;
+            f.step  = ONE / ticks;
+            mask |= (1U << ch);
+        }
+    }
+
+    void stop(uint8_t ch)
+    {
+        mask &= ~(1U << ch);
+    }
+
+    uint16_t active(void)
+    {
+        return mask;
+    }
+
+    void run(void)
+    {
+        if(mask == 0) return;
+        uint8_t now = SysTick::ticks();
+        uint8_t dt  = now - lastTick;
+        if(dt == 0) return;
+        lastTick = now;
+
+        uint16_t m = 1;
+        for(uint8_t ch = 0; ch < MAX_CH; ch++, m <<= 1) {
+            if(!(mask & m)) continue;
+            if(chan[ch].internal) {
+                mask &= ~m;
+                continue;
+            }
+            Fade &f = fades[ch];
+            f.phase += f.step * dt;
+            if(f.phase >= ONE) {
+                mask &= ~m;
+                chan[ch].setVal(f.to);
+                continue;
+            }
+            int16_t  d = (int16_t)f.to - f.from;
+            uint16_t e = ease((uint16_t)(f.phase >> 8), f.curve);
+            chan[ch].setVal((uint8_t)(f.from + (int16_t)(((int32_t)d * e) >> 16)));
+        }
+    }
+}
+
+// end Fader.cpp
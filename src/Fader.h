@@ -0,0 +1,54 @@
+// =======================================================================
+// @file        Fader.h
+//
+// @project     NanoPWM
+// @details     Non-blocking per-channel fades (transitions)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __FADER__H__
+#define __FADER__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Each channel can run a fade from its current setpoint to a target, over
+// a given time, along an easing curve. Progress is a fixed-point phase
+// (Q24, 0..1) advanced by a fixed step per SysTick tick; run() catches up
+// with the ticks elapsed since its last call and applies the eased value,
+// so timing does not depend on the loop rate (as long as the loop does
+// not stall for more than 255 ticks).
+//
+// A fading channel is switched to external source; a fade is cancelled by
+// any other setpoint for that channel (serial, I2C, DMX) or by switching
+// it back to internal.
+
+namespace Fader
+{
+    enum Curve : uint8_t {
+        LINEAR  = 0,
+        IN      = 1,    // Quadratic ease-in (slow start)
+        OUT     = 2,    // Quadratic ease-out (slow end)
+        IN_OUT  = 3,    // Smoothstep
+        NumCurves
+    };
+
+    /// Start fading the channels in <mask> to <target> in <ms> milliseconds
+    void    start(uint16_t mask, uint8_t target, uint32_t ms, uint8_t curve);
+
+    void    stop(uint8_t ch);
+
+    /// Eased progress of curve <curve> at <p>; both in Q16 (0..1)
+    uint16_t ease(uint16_t p, uint8_t curve);
+
+    /// Bit mask of channels fading
+    uint16_t active(void);
+
+    /// Advance fades; call from main loop
+    void    run(void);
+}
+
+#endif  //!__FADER__H__
@@ -0,0 +1,195 @@
+// =======================================================================
+// @file        I2cRegs.cpp
+//
+// @project     NanoPWM
+// @details     I2C slave interface: register-map protocol
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "I2cRegs.h"
+#include "main.h"
+
+#ifdef USE_I2C
+
+#include <Wire.h>
+#include "Latch.h"
+#include "Player.h"
+#ifdef USE_DMX
+#include "Dmx.h"
+#endif
+
+namespace I2cRegs
+{
+    constexpr uint8_t BufLen = 32;      // Same as the Wire library buffers
+
+    // Register pointer (set by the first byte of a write)
+    volatile uint8_t    ptr     = 0;
+
+    // Write transaction queued for process()
+    uint8_t             rxReg;
+    uint8_t             rxLen;
+    uint8_t             rxBuf[BufLen];
+    volatile bool       rxPending = false;
+    uint8_t             rxDrops   = 0;      // Writes dropped (ISR only)
+
+    // Counter MSB latched by a read starting at its LSB (ISR only)
+    uint8_t             snapReg   = 0xFF;
+    uint8_t             snapMsb;
+
+    // Set while applying a transaction (for end-of-transaction actions)
+    bool                dmxTouched;
+    uint16_t            dmxNew;             // DMX address being written
+
+    static uint8_t readReg(uint8_t reg)
+    {
+        if(reg < R_FLAGS) {
+            return (reg < MAX_CH) ? chan[reg].PWMval : 0xFF;
+        }
+        if(reg < R_STATUS) {
+            uint8_t n = reg - R_FLAGS;
+            if(n >= MAX_CH) return 0xFF;
+            return (chan[n].active     ? 0x01 : 0)
+                 | (chan[n].internal   ? 0x02 : 0)
+                 | (chan[n].reverse    ? 0x04 : 0)
+                 | (chan[n].LEDcorrect ? 0x08 : 0);
+        }
+        if(reg < R_WRITES) {
+            uint8_t n = reg - R_STATUS;
+            if(n >= MAX_CH) return 0xFF;
+            return (chan[n].outVal != 0     ? 0x01 : 0)
+                 | (chan[n].out.bits() > 8  ? 0x02 : 0);
+        }
+        if(reg < R_NCH) {
+            // 16-bit counters, LSB first
+            bool     skips = (reg >= R_SKIPS);
+            uint8_t  n     = (reg - (skips ? R_SKIPS : R_WRITES)) >> 1;
+            if(n >= MAX_CH) return 0xFF;
+            uint16_t v     = skips ? chan[n].skipCnt : chan[n].writeCnt;
+            return (reg & 1) ? (uint8_t)(v >> 8) : (uint8_t)v;
+        }
+        switch(reg) {
+            case R_NCH:         return MAX_CH;
+            case R_VERSION:     return MapVersion;
+            case R_DMXADDR:     return (uint8_t)dmxAddr;
+            case R_DMXADDR+1:   return (uint8_t)(dmxAddr >> 8);
+            case R_CMD:         return 0;
+            case R_DROPS:       return rxDrops;
+            default:            return 0xFF;
+        }
+    }
+
+    static void writeReg(uint8_t reg, uint8_t val)
+    {
+        if(reg < R_FLAGS) {
+            if(reg < MAX_CH) Latch::stage(reg, val);
+            return;
+        }
+        if(reg < R_STATUS) {
+            uint8_t n = reg - R_FLAGS;
+            if(n >= MAX_CH) return;
+            chan[n].active      = (val & 0x01);
+            chan[n].internal    = (val & 0x02);
+            chan[n].reverse     = (val & 0x04);
+            chan[n].LEDcorrect  = (val & 0x08);
+            chan[n].refresh();
+            return;
+        }
+        switch(reg) {
+            case R_DMXADDR:
+                dmxNew = (dmxNew & 0xFF00) | val;
+                dmxTouched = true;
+                break;
+            case R_DMXADDR+1:
+                dmxNew = (dmxNew & 0x00FF) | ((uint16_t)val << 8);
+                dmxTouched = true;
+                break;
+            case R_CMD:
+                if(val == 1) saveParams();
+                if(val == 2) fetchParams();
+                if(val == 3) resetParams();
+                if(val == 4) Player::stop();
+                if(val == 2 || val == 3) {
+                    for(uint8_t i = 0; i < MAX_CH; i++) chan[i].refresh();
+                }
+                break;
+            default:
+                // Read-only or unmapped
+                break;
+        }
+    }
+
+    // TWI interrupt context
+    static void onReceive(int n)
+    {
+        if(n < 1) return;
+        uint8_t reg = Wire.read();
+        n--;
+        ptr = reg;
+        if(n == 0) return;      // Register select only (before a read)
+        if(rxPending) {
+            // Previous write not applied yet: drop this one (the master
+            // can see it in R_DROPS)
+            while(Wire.available()) Wire.read();
+            if(rxDrops < 0xFF) rxDrops++;
+            return;
+        }
+        uint8_t i = 0;
+        while(Wire.available() && i < BufLen) rxBuf[i++] = Wire.read();
+        rxReg     = reg;
+        rxLen     = i;
+        rxPending = true;
+    }
+
+    // TWI interrupt context
+    static void onRequest(void)
+    {
+        uint8_t buf[BufLen];
+        uint8_t r = ptr;
+        for(uint8_t i = 0; i < BufLen; i++) buf[i] = readReg(r++);
+        // A master reading a 16-bit counter one byte per transaction gets
+        // the MSB as it was when it read the LSB, so the two always match
+        bool cnt = (ptr >= R_WRITES && ptr < R_NCH);
+        if(cnt && (ptr & 1) && snapReg == ptr - 1) buf[0] = snapMsb;
+        snapReg = (cnt && !(ptr & 1)) ? ptr : 0xFF;
+        snapMsb = buf[1];
+        Wire.write(buf, BufLen);
+    }
+
+    void begin(uint8_t addr)
+    {
+        Wire.begin(addr);
+        Wire.onReceive(onReceive);
+        Wire.onRequest(onRequest);
+    }
+
+    void process(void)
+    {
+        if(!rxPending) return;
+
+        dmxTouched = false;
+        dmxNew     = dmxAddr;
+        uint8_t r = rxReg;
+        for(uint8_t i = 0; i < rxLen; i++) writeReg(r++, rxBuf[i]);
+        if(Latch::pending()) Latch::commit();
+        // Same range as "M"; an address out of range is ignored
+        if(dmxTouched && dmxNew >= 1 && dmxNew <= DMX_ADDR_MAX) {
+            dmxAddr = dmxNew;
+#ifdef USE_DMX
+            Dmx::setAddress(dmxAddr);
+#endif
+        }
+        rxPending = false;
+    }
+
+    bool pending(void)
+    {
+        return rxPending;
+    }
+}
+
+#endif  //USE_I2C
+
+// end I2cRegs.cpp
@@ -0,0 +1,78 @@
+// =======================================================================
+// @file        I2cRegs.h
+//
+// @project     NanoPWM
+// @details     I2C slave interface: register-map protocol
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __I2CREGS__H__
+#define __I2CREGS__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Protocol (usual register-pointer scheme):
+//   Write:  [reg] [data0] [data1] ...  data written from <reg> on
+//   Read:   write [reg], then read n bytes from <reg> on
+// The register pointer auto-increments over a burst, so e.g. all
+// setpoints can be written in a single transaction; it is not advanced
+// by reads (each read starts from the last register written/selected).
+//
+// Registers are not a copy: they map directly onto the channel fields
+// used by the serial interface.
+//
+// Map (n = channel number, 0..MAX_CH-1):
+//   0x00+n  RW  Setpoint. A burst of setpoints is applied all together
+//               at the end of the transaction (see Latch); channels are
+//               switched to external source, as with "V".
+//   0x10+n  RW  Flags: b0 active, b1 internal, b2 reverse, b3 CIE correct
+//   0x20+n  RO  Status: b0 output on, b1 12-bit output
+//   0x30+2n RO  Output writes (16 bit, LSB first)
+//   0x50+2n RO  Output writes skipped (unchanged value; 16 bit, LSB first)
+//               A read starting at the LSB latches the MSB, for a
+//               following read starting at the MSB
+//   0x70    RO  Number of channels
+//   0x71    RO  Register map version
+//   0x72    RW  DMX start address (16 bit, LSB first; applied at end of
+//   0x73        transaction, if in range 1..DMX_ADDR_MAX)
+//   0x74    WO  Command: 1 = save params, 2 = revert to saved, 3 = factory
+//               reset, 4 = stop script (reads as 0)
+//   0x75    RO  Write transactions dropped (saturates at 255)
+//
+// Wire callbacks run in the TWI interrupt: received bytes are only queued
+// there, and applied from the main loop by process(). Reads are served
+// from the interrupt directly.
+// One write transaction is queued at a time: a write arriving before the
+// previous one was applied has already been acked by the TWI hardware,
+// and is dropped; masters should space writes, or check 0x75.
+
+namespace I2cRegs
+{
+    constexpr uint8_t R_VALUE    = 0x00;
+    constexpr uint8_t R_FLAGS    = 0x10;
+    constexpr uint8_t R_STATUS   = 0x20;
+    constexpr uint8_t R_WRITES   = 0x30;
+    constexpr uint8_t R_SKIPS    = 0x50;
+    constexpr uint8_t R_NCH      = 0x70;
+    constexpr uint8_t R_VERSION  = 0x71;
+    constexpr uint8_t R_DMXADDR  = 0x72;
+    constexpr uint8_t R_CMD      = 0x74;
+    constexpr uint8_t R_DROPS    = 0x75;
+    constexpr uint8_t RegCount   = 0x76;
+
+    constexpr uint8_t MapVersion = 2;
+
+    void    begin(uint8_t addr);
+
+    /// Apply a received write transaction, if any. Call from main loop.
+    void    process(void);
+
+    /// True if a write transaction is waiting for process()
+    bool    pending(void);
+}
+
+#endif  //!__I2CREGS__H__
@@ -0,0 +1,70 @@
+// =======================================================================
+// @file        Latch.cpp
+//
+// @project     NanoPWM
+// @details     Staged channel values, applied together on latch
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Latch.h"
+#include "Fader.h"
+#ifdef USE_SOFT_PWM
+#include "SoftPwm.h"
+#endif
+
+namespace Latch
+{
+    uint8_t     vals[MAX_CH];
+    uint16_t    mask = 0;
+
+    void stage(uint8_t ch, uint8_t val)
+    {
+        if(ch >= MAX_CH) return;
+        vals[ch] = val;
+        mask |= (1U << ch);
+    }
+
+    void commit(void)
+    {
+        uint16_t wr = 0;    // Channels whose output must be written
+        uint16_t m  = 1;
+
+        // Compute outputs (CIE lookup etc.) outside the critical section
+        for(uint8_t ch = 0; ch < MAX_CH; ch++, m <<= 1) {
+            if(!(mask & m)) continue;
+            Fader::stop(ch);
+            chan[ch].internal = false;
+            if(chan[ch].prepVal(vals[ch])) wr |= m;
+        }
+        mask = 0;
+        if(!wr) return;
+
+#ifdef USE_SOFT_PWM
+        SoftPwm::hold(true);
+#endif
+        noInterrupts();
+        m = 1;
+        for(uint8_t ch = 0; ch < MAX_CH; ch++, m <<= 1) {
+            if(wr & m) chan[ch].applyVal();
+        }
+        interrupts();
+#ifdef USE_SOFT_PWM
+        SoftPwm::hold(false);
+#endif
+    }
+
+    void discard(void)
+    {
+        mask = 0;
+    }
+
+    uint16_t pending(void)
+    {
+        return mask;
+    }
+}
+
+// end Latch.cpp
@@ -0,0 +1,41 @@
+// =======================================================================
+// @file        Latch.h
+//
+// @project     NanoPWM
+// @details     Staged channel values, applied together on latch
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __LATCH__H__
+#define __LATCH__H__
+
+#include <stdint.h>
+#include "main.h"
+
+// Values for any subset of channels are staged into a shadow buffer
+// (possibly over several commands/frames), then applied by commit():
+// all output values are computed first, then all outputs are written in
+// a single block with interrupts off. Hardware PWM compare registers are
+// double-buffered, so the new duties start together at the next PWM
+// period (per timer); soft PWM outputs are handed to the ISR as a whole.
+
+namespace Latch
+{
+    /// Stage <val> for channel <ch> (replaces any value already staged)
+    void    stage(uint8_t ch, uint8_t val);
+
+    /// Apply all staged values (channels are switched to external source,
+    /// as with "V"; fades are cancelled) and clear the stage
+    void    commit(void);
+
+    /// Drop staged values
+    void    discard(void);
+
+    /// Bit mask of staged channels
+    uint16_t pending(void);
+}
+
+#endif  //!__LATCH__H__
@@ -13,50 +13,21 @@
 
 namespace PWMtables
 {
+    // Checksums of the tables as they were hand-generated: the generator
+    // must keep reproducing them exactly
+    static_assert(checksum(cie, 8)  == 0x57794A6EUL, "CIE 8-bit table changed");
+    static_assert(checksum(cie, 12) == 0x58FAA67FUL, "CIE 12-bit table changed");
+    static_assert(cie(255, 8) == 255 && cie(255, 12) == 4095, "CIE full scale");
+
     // CIE 8-bit
     // Lookup table for 256 CIE Lab brightness corrected values 
     // with 8 bit resolution (0...255)
-    const uint8_t TAB_CIE_8[256] PROGMEM = {
-        0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  
-        2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  3,  4,  4,  
-        4,  4,  4,  4,  5,  5,  5,  5,  5,  5,  6,  6,  6,  6,  6,  7,  
-        7,  7,  7,  8,  8,  8,  8,  9,  9,  9,  10, 10, 10, 10, 11, 11, 
-        11, 12, 12, 12, 13, 13, 13, 14, 14, 15, 15, 15, 16, 16, 17, 17, 
-        17, 18, 18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 23, 24, 24, 25, 
-        25, 26, 26, 27, 28, 28, 29, 29, 30, 31, 31, 32, 33, 33, 34, 35, 
-        35, 36, 37, 37, 38, 39, 40, 40, 41, 42, 43, 44, 44, 45, 46, 47, 
-        48, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 58, 59, 60, 61, 
-        62, 63, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 77, 78, 79, 
-        80, 81, 83, 84, 85, 86, 88, 89, 90, 91, 93, 94, 95, 97, 98, 99, 
-        101,102,104,105,107,108,109,111,112,114,115,117,119,120,122,123,
-        125,126,128,130,131,133,135,136,138,140,142,143,145,147,149,151,
-        152,154,156,158,160,162,164,166,168,170,171,173,175,178,180,182,
-        184,186,188,190,192,194,196,199,201,203,205,208,210,212,214,217,
-        219,221,224,226,229,231,233,236,238,241,243,246,248,251,253,255,
-    };
+    const uint8_t TAB_CIE_8[256] PROGMEM = { PWM_TABLE(cie, 8) };
     
     // CIE 12-bit
     // Lookup table for 256 CIE Lab brightness corrected values 
     // with 12 bit resolution (0...4095)
-    /*
-    const uint16_t TAB_CIE_12[256] PROGMEM = {
-        0,2,4,5,7,9,11,12,14,16,18,20,21,23,25,27,28,30,32,34,36,37,39,41,43,45,47,49,
-        52,54,56,59,61,64,66,69,72,75,77,80,83,87,90,93,97,100,103,107,111,115,118,122,
-        126,131,135,139,144,148,153,157,162,167,172,177,182,187,193,198,204,209,215,221,
-        227,233,239,246,252,259,265,272,279,286,293,300,308,315,323,330,338,346,354,362,
-        371,379,388,396,405,414,423,432,442,451,461,471,480,490,501,511,521,532,543,554,
-        565,576,587,599,610,622,634,646,658,670,683,696,708,721,734,748,761,775,789,802,
-        817,831,845,860,875,890,905,920,935,951,967,983,999,1015,1032,1048,1065,1082,
-        1099,1117,1134,1152,1170,1188,1206,1225,1243,1262,1281,1301,1320,1340,1359,1379,
-        1400,1420,1441,1461,1482,1504,1525,1547,1568,1590,1613,1635,1658,1681,1704,1727,
-        1750,1774,1798,1822,1846,1871,1896,1921,1946,1971,1997,2023,2049,2075,2101,2128,
-        2155,2182,2210,2237,2265,2293,2322,2350,2379,2408,2437,2467,2497,2527,2557,2587,
-        2618,2649,2680,2712,2743,2775,2807,2840,2872,2905,2938,2972,3006,3039,3074,3108,
-        3143,3178,3213,3248,3284,3320,3356,3393,3430,3467,3504,3542,3579,3617,3656,3694,
-        3733,3773,3812,3852,3892,3932,3973,4013,4055,4095
-    };
-    */
+    const uint16_t TAB_CIE_12[256] PROGMEM = { PWM_TABLE(cie, 12) };
 }
 
 // PWMtables.cpp
-
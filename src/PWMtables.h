@@ -6,7 +6,7 @@
 //  for PWM outputs for LEDs, in order to obtain a perceived brightness 
 //  matching the setting value.
 //  The input value is in the range 0-255;
-//  The output value is in the range 0-255
+//  The output value is in the range 0-255 (0-4095 for 12-bit tables)
 //
 // @author      GiorgioCC (g.crocic@gmail.com) - 2023-08-20
 // @modifiedby  GiorgioCC - 2023-08-25 17:39
@@ -20,7 +20,7 @@
 #include <stdint.h>
 
 #ifdef ARDUINO_ARCH_AVR
-    #include <avr\pgmspace.h>
+    #include <avr/pgmspace.h>
     // Reminder - to access table value in progmem:
     // For 8-bit values:
     //   uint8_t v;
@@ -31,15 +31,77 @@
     //   const uint16_t* p;
     //   v = pgm_read_word_near(p++);
 #else
-    #define PROGMEM 
+    // Host / non-AVR builds: tables live in plain const memory
+    #define PROGMEM
+    #define pgm_read_byte(p)    (*(const uint8_t*)(p))
+    #define pgm_read_word(p)    (*(const uint16_t*)(p))
 #endif
 
 namespace PWMtables
 {
-    // extern const uint16_t   TAB_CIE_12[256];        // CIE 12-bit
+    extern const uint16_t   TAB_CIE_12[256];        // CIE 12-bit
     extern const uint8_t    TAB_CIE_8[256];         // CIE 8-bit
+
+    // Table generators: value for input <x> (0..255) at <bits> (8..16)
+    // of output resolution, usable in constant expressions.
+    // Tables are filled at compile time with PWM_TABLE(curve, bits).
+
+    constexpr uint64_t cube(uint64_t v) { return v * v * v; }
+
+    // CIE 1931 lightness to luminance, with L* = 100x/255:
+    //   L* <= 8:  Y = L* / 903.3
+    //   L* >  8:  Y = ((L* + 16) / 116)^3
+    // computed as exact integer ratios and rounded to <bits>:
+    //   x <= 20:  Y = 1000x / 2303415
+    //   x >  20:  Y = (100x + 4080)^3 / 29580^3
+    constexpr uint64_t CieDen = 2303415ULL;
+    constexpr uint64_t CieCube = 29580ULL * 29580 * 29580;
+
+    constexpr uint32_t cieRound(uint8_t x, uint8_t bits)
+    {
+        return (x <= 20)
+            ? (uint32_t)((((2000ULL * x) << bits) + CieDen) / (2 * CieDen))
+            : (uint32_t)((((2 * cube(100ULL * x + 4080)) << bits) + CieCube) / (2 * CieCube));
+    }
+
+    constexpr uint16_t clampBits(uint32_t v, uint8_t bits)
+    {
+        return (uint16_t)((v < (1UL << bits)) ? v : (1UL << bits) - 1);
+    }
+
+    // Below 12 bits, values are rounded from the 12-bit ones (as in the
+    // tables this replaces), not directly from Y
+    constexpr uint16_t cie(uint8_t x, uint8_t bits)
+    {
+        return (bits >= 12)
+            ? clampBits(cieRound(x, bits), bits)
+            : clampBits(((uint32_t)cie(x, 12) + (1U << (11 - bits))) >> (12 - bits), bits);
+    }
+
+    constexpr uint16_t linear(uint8_t x, uint8_t bits)
+    {
+        // Replicate the top bits into the extra LSBs, so that 255 -> max
+        return (uint16_t)(((uint32_t)x << (bits - 8)) | ((uint32_t)x >> (16 - bits)));
+    }
+
+    // Fletcher-16 style checksum of a generated table (a | b << 16)
+    constexpr uint32_t checksum(uint16_t (*curve)(uint8_t, uint8_t), uint8_t bits,
+                                uint16_t i = 0, uint16_t a = 0, uint16_t b = 0)
+    {
+        return (i == 256)
+            ? ((uint32_t)b << 16) | a
+            : checksum(curve, bits, i + 1,
+                       (uint16_t)(a + curve((uint8_t)i, bits)),
+                       (uint16_t)(b + a + curve((uint8_t)i, bits)));
+    }
 }
 
+// Initializer list for a 256-entry table: curve(0, bits) ... curve(255, bits)
+#define PWMT_4(c, b, i)     c((i), b), c((i)+1, b), c((i)+2, b), c((i)+3, b)
+#define PWMT_16(c, b, i)    PWMT_4(c, b, i), PWMT_4(c, b, (i)+4), PWMT_4(c, b, (i)+8), PWMT_4(c, b, (i)+12)
+#define PWMT_64(c, b, i)    PWMT_16(c, b, i), PWMT_16(c, b, (i)+16), PWMT_16(c, b, (i)+32), PWMT_16(c, b, (i)+48)
+#define PWM_TABLE(c, b)     PWMT_64(c, b, 0), PWMT_64(c, b, 64), PWMT_64(c, b, 128), PWMT_64(c, b, 192)
+
 #endif  //__PWMTABLE_H__
 
 
@@ -0,0 +1,239 @@
+// =======================================================================
+// @file        Player.cpp
+//
+// @project     NanoPWM
+// @details     Non-blocking sequence (script) player
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Player.h"
+#include "main.h"
+#include "Fader.h"
+
+// Ramp (0->100%->0, 1 s each way) on the channels in <m>
+#define DEMO_RAMP(m)    PL_SET(m, 0), PL_FADE(m, 255, 100, 0), PL_SYNC, \
+                        PL_FADE(m, 0, 100, 0), PL_SYNC
+
+#define DEMO_SEQ        DEMO_RAMP(0x001), DEMO_RAMP(0x002), DEMO_RAMP(0x004), \
+                        DEMO_RAMP(0x008), DEMO_RAMP(0x010), DEMO_RAMP(0x020), \
+                        DEMO_RAMP(0x040), DEMO_RAMP(0x080), DEMO_RAMP(0x100), \
+                        DEMO_RAMP(0x200)
+
+#define DEMO_ALL        DEMO_RAMP(0x3FF)
+
+const uint8_t ScrSeq[]  PROGMEM = { DEMO_SEQ, PL_END };
+const uint8_t ScrAll[]  PROGMEM = { DEMO_ALL, PL_END };
+const uint8_t ScrBoot[] PROGMEM = { DEMO_SEQ, DEMO_ALL, PL_END };
+
+static_assert(sizeof(ScrBoot) <= 256, "Scripts are addressed by an 8-bit pc");
+
+namespace Player
+{
+    constexpr uint16_t ALL_CH = (uint16_t)((1UL << MAX_CH) - 1);
+
+    struct LoopFrame
+    {
+        uint8_t     pc;         // Start of loop body
+        uint8_t     cnt;        // Passes left (0 = forever)
+    };
+
+    const uint8_t  *prog    = nullptr;  // PROGMEM script, or null for EEPROM
+    bool            active  = false;
+    bool            repeat;
+    bool            hold;
+    uint8_t         pc;
+    uint8_t         depth;
+    LoopFrame       loops[MaxDepth];
+    bool            waiting;
+    unsigned long   waitStart;
+    uint32_t        waitMs;
+    uint16_t        touched;            // Channels driven by the script
+    uint16_t        bakInternal;
+    uint8_t         bakVals[MAX_CH];
+
+    static uint8_t fetch(void)
+    {
+        uint8_t b;
+        if(prog) {
+            b = pgm_read_byte(prog + pc);
+        } else {
+            b = (pc < EESize) ? EEconfig::readByte(EEBase + pc) : 0xFF;
+        }
+        pc++;
+        return b;
+    }
+
+    static uint16_t fetchWord(void)
+    {
+        uint16_t w = fetch();
+        return w | ((uint16_t)fetch() << 8);
+    }
+
+    static uint16_t fetchMask(void)
+    {
+        return fetchWord() & ALL_CH;
+    }
+
+    static void rewind(void)
+    {
+        pc      = 0;
+        depth   = 0;
+        waiting = false;
+    }
+
+    // Note channels about to be driven, saving their state the first time
+    static void touch(uint16_t mask)
+    {
+        uint16_t m = 1;
+        mask &= ~touched;
+        for(uint8_t ch = 0; ch < MAX_CH; ch++, m <<= 1) {
+            if(!(mask & m)) continue;
+            bakVals[ch] = chan[ch].getVal();
+            if(chan[ch].internal) bakInternal |= m;
+        }
+        touched |= mask;
+    }
+
+    void start(uint8_t id, bool rep)
+    {
+        stop();
+        switch(id) {
+            case SEQ:   prog = ScrSeq;  break;
+            case ALL:   prog = ScrAll;  break;
+            case BOOT:  prog = ScrBoot; break;
+            default:    prog = nullptr; break;
+        }
+        repeat      = rep;
+        hold        = false;
+        touched     = 0;
+        bakInternal = 0;
+        rewind();
+        active      = true;
+    }
+
+    void stop(void)
+    {
+        if(!active) return;
+        active = false;
+        if(hold) return;
+        uint16_t m = 1;
+        for(uint8_t ch = 0; ch < MAX_CH; ch++, m <<= 1) {
+            if(!(touched & m)) continue;
+            Fader::stop(ch);
+            chan[ch].internal = (bakInternal & m);
+            chan[ch].setVal(bakVals[ch]);
+        }
+    }
+
+    bool running(void)
+    {
+        return active;
+    }
+
+    bool store(uint8_t ofs, const uint8_t *data, uint8_t len)
+    {
+        if((uint16_t)ofs + len > EESize) return false;
+        // Don't pull the script from under the player
+        if(active && !prog) stop();
+        for(uint8_t i = 0; i < len; i++) {
+            EEconfig::updateByte(EEBase + ofs + i, data[i]);
+        }
+        return true;
+    }
+
+    void run(void)
+    {
+        if(!active) return;
+
+        if(waiting) {
+            if((millis() - waitStart) < waitMs) return;
+            waiting = false;
+        }
+
+        for(uint8_t n = 0; n < MaxSteps; n++) {
+            uint8_t op = fetch();
+            switch(op) {
+                case OP_END:
+                    if(!repeat) {
+                        stop();
+                        return;
+                    }
+                    rewind();
+                    // Yield once per pass, in case the script has no waits
+                    return;
+
+                case OP_SET:
+                {
+                    uint16_t mask = fetchMask();
+                    uint8_t  v    = fetch();
+                    touch(mask);
+                    Fader::start(mask, v, 0, Fader::LINEAR);
+                    break;
+                }
+
+                case OP_FADE:
+                {
+                    uint16_t mask = fetchMask();
+                    uint8_t  v    = fetch();
+                    uint16_t t    = fetchWord();
+                    uint8_t  c    = fetch();
+                    touch(mask);
+                    Fader::start(mask, v, (uint32_t)t * 10, c);
+                    break;
+                }
+
+                case OP_WAIT:
+                    waitMs    = (uint32_t)fetchWord() * 10;
+                    waitStart = millis();
+                    waiting   = true;
+                    return;
+
+                case OP_SYNC:
+                    if(Fader::active() & touched) {
+                        pc--;       // Check again on next call
+                        return;
+                    }
+                    break;
+
+                case OP_LOOP:
+                    if(depth >= MaxDepth) {
+                        stop();
+                        return;
+                    }
+                    loops[depth].cnt = fetch();
+                    loops[depth].pc  = pc;
+                    depth++;
+                    break;
+
+                case OP_NEXT:
+                {
+                    if(depth == 0) {
+                        stop();
+                        return;
+                    }
+                    LoopFrame &lf = loops[depth-1];
+                    if(lf.cnt == 0 || --lf.cnt != 0) {
+                        pc = lf.pc;
+                    } else {
+                        depth--;
+                    }
+                    break;
+                }
+
+                case OP_HOLD:
+                    hold = true;
+                    break;
+
+                default:
+                    // Bad opcode (or erased EEPROM)
+                    stop();
+                    return;
+            }
+        }
+    }
+}
+
+// end Player.cpp
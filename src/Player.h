@@ -0,0 +1,102 @@
+// =======================================================================
+// @file        Player.h
+//
+// @project     NanoPWM
+// @details     Non-blocking sequence (script) player
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __PLAYER__H__
+#define __PLAYER__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Scripts are a compact bytecode, read in place from PROGMEM (built-in
+// ones) or from a reserved EEPROM area (user script, uploaded with "W").
+// run() is called from the main loop: it executes at most MaxSteps
+// instructions per call and yields on WAIT/SYNC, so a script never
+// blocks command processing; fades are handed over to Fader.
+// No heap is used: player state is a program counter, a wait deadline
+// and a small loop stack.
+//
+// Channels touched by a script are switched to external source; when the
+// script ends or is stopped, their previous setpoints and source are
+// restored (as the old blocking demo did), unless the script ran HOLD.
+//
+// Instructions (16-bit args LSB first; masks: bit n = ch. #n, bits beyond
+// the last channel are ignored; times in 10 ms units):
+//   0x00  END                      End of script (or restart, if repeated)
+//   0x01  SET   mask val           Set channels to val (cancels fades)
+//   0x02  FADE  mask val time crv  Start fade (see Fader::Curve)
+//   0x03  WAIT  time               Pause
+//   0x04  SYNC                     Wait until the script's fades are over
+//   0x05  LOOP  n                  Repeat body up to NEXT n times (0 = forever)
+//   0x06  NEXT                     End of LOOP body
+//   0x07  HOLD                     Keep setpoints when the script ends
+// Any other byte (e.g. 0xFF, erased EEPROM) stops the script.
+
+#define PL_LO(w)                ((uint8_t)((w) & 0xFF))
+#define PL_HI(w)                ((uint8_t)(((w) >> 8) & 0xFF))
+#define PL_END                  Player::OP_END
+#define PL_SET(m, v)            Player::OP_SET, PL_LO(m), PL_HI(m), (v)
+#define PL_FADE(m, v, t, c)     Player::OP_FADE, PL_LO(m), PL_HI(m), (v), PL_LO(t), PL_HI(t), (c)
+#define PL_WAIT(t)              Player::OP_WAIT, PL_LO(t), PL_HI(t)
+#define PL_SYNC                 Player::OP_SYNC
+#define PL_LOOP(n)              Player::OP_LOOP, (n)
+#define PL_NEXT                 Player::OP_NEXT
+#define PL_HOLD                 Player::OP_HOLD
+
+namespace Player
+{
+    enum Op : uint8_t {
+        OP_END  = 0x00,
+        OP_SET  = 0x01,
+        OP_FADE = 0x02,
+        OP_WAIT = 0x03,
+        OP_SYNC = 0x04,
+        OP_LOOP = 0x05,
+        OP_NEXT = 0x06,
+        OP_HOLD = 0x07,
+    };
+
+    enum Script : uint8_t {
+        SEQ     = 0,    // Ramp each channel in turn (built-in)
+        ALL     = 1,    // Ramp all channels together (built-in)
+        USER    = 2,    // Script in EEPROM
+        BOOT    = 3,    // SEQ then ALL (built-in, demo jumper at boot)
+        NumScripts
+    };
+
+    constexpr uint8_t  MaxSteps  = 8;       // Instructions per run() call
+    constexpr uint8_t  MaxDepth  = 2;       // LOOP nesting
+
+    // User script area: top of EEPROM (config store uses the bottom)
+    constexpr uint16_t EESize    = 128;
+#ifdef E2END
+    constexpr uint16_t EEBase    = (uint16_t)(E2END + 1 - EESize);
+#else
+    constexpr uint16_t EEBase    = 1024 - EESize;
+#endif
+
+    /// Start script <id> (stops the one running, if any); with <repeat>,
+    /// restart from the beginning at END
+    void    start(uint8_t id, bool repeat);
+
+    /// Stop script and restore touched channels (unless HOLD)
+    void    stop(void);
+
+    bool    running(void);
+
+    /// Write <len> bytes to the user script area at <ofs>;
+    /// returns false if out of range
+    bool    store(uint8_t ofs, const uint8_t *data, uint8_t len);
+
+    /// Execute script; call from main loop
+    void    run(void);
+}
+
+#endif  //!__PLAYER__H__
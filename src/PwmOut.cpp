@@ -0,0 +1,257 @@
+// =======================================================================
+// @file        PwmOut.cpp
+//
+// @project     NanoPWM
+// @details     Direct timer-register PWM output
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "PwmOut.h"
+#include "main.h"
+#ifdef USE_SOFT_PWM
+#include "SoftPwm.h"
+#endif
+
+PwmOut::
+PwmOut(void)
+: ocr(nullptr), tccr(nullptr), comInv(0), kind(NONE), tmr(0xFF),
+fastPwm(false), inverted(false), pin(0xFF), slot(0), inBits(8), shift(0), dither(false),
+ditOn(false), ditBase(0), ditFrac(0), ditAcc(0)
+{}
+
+uint8_t PwmOut::t1Bits = 8;
+
+void PwmOut::
+begin(uint8_t Ppin, uint8_t bits)
+{
+    uint8_t comNorm = 0;
+    bool    timer1  = false;
+
+    pin    = Ppin;
+    kind   = NONE;
+    tmr    = 0xFF;
+    inBits = 8;
+    shift  = 0;
+    dither = false;
+    ditOn  = false;
+    digitalWrite(pin, 0);
+    pinMode(pin, OUTPUT);
+
+#ifdef ARDUINO_ARCH_AVR
+    #ifdef USE_SOFT_PWM
+    uint8_t tmr = digitalPinToTimer(pin);
+    if(tmr == NOT_ON_TIMER || tmr == TIMER2A || tmr == TIMER2B || tmr == TIMER2) {
+        int8_t s = SoftPwm::addPin(pin);
+        if(s >= 0) {
+            slot = (uint8_t)s;
+            kind = SOFT;
+        }
+        return;
+    }
+    #endif
+
+    // Timer modes are the ones set by the core's init():
+    // Timer0 fast PWM, all others phase-correct.
+    switch(digitalPinToTimer(pin)) {
+    #if defined(TCCR0A) && defined(COM0A1)
+        case TIMER0A:
+            tmr = 0;
+            ocr = &OCR0A; tccr = &TCCR0A; kind = T8; fastPwm = true;
+            comNorm = _BV(COM0A1); comInv = _BV(COM0A0);
+            break;
+    #endif
+    #if defined(TCCR0A) && defined(COM0B1)
+        case TIMER0B:
+            tmr = 0;
+            ocr = &OCR0B; tccr = &TCCR0A; kind = T8; fastPwm = true;
+            comNorm = _BV(COM0B1); comInv = _BV(COM0B0);
+            break;
+    #endif
+    #if defined(TCCR1A) && defined(COM1A1)
+        case TIMER1A:
+            tmr = 1;
+            ocr = &OCR1A; tccr = &TCCR1A; kind = T16; fastPwm = false;
+            comNorm = _BV(COM1A1); comInv = _BV(COM1A0); timer1 = true;
+            break;
+    #endif
+    #if defined(TCCR1A) && defined(COM1B1)
+        case TIMER1B:
+            tmr = 1;
+            ocr = &OCR1B; tccr = &TCCR1A; kind = T16; fastPwm = false;
+            comNorm = _BV(COM1B1); comInv = _BV(COM1B0); timer1 = true;
+            break;
+    #endif
+    #if defined(TCCR2A) && defined(COM2A1)
+        case TIMER2A:
+            tmr = 2;
+            ocr = &OCR2A; tccr = &TCCR2A; kind = T8; fastPwm = false;
+            comNorm = _BV(COM2A1); comInv = _BV(COM2A0);
+            break;
+    #endif
+    #if defined(TCCR2A) && defined(COM2B1)
+        case TIMER2B:
+            tmr = 2;
+            ocr = &OCR2B; tccr = &TCCR2A; kind = T8; fastPwm = false;
+            comNorm = _BV(COM2B1); comInv = _BV(COM2B0);
+            break;
+    #endif
+    #if defined(TCCR3A) && defined(COM3A1)
+        case TIMER3A:
+            tmr = 3;
+            ocr = &OCR3A; tccr = &TCCR3A; kind = T16; fastPwm = false;
+            comNorm = _BV(COM3A1); comInv = _BV(COM3A0);
+            break;
+    #endif
+        default:
+            // e.g. Timer4 on 32U4: leave it to analogWrite()
+            return;
+    }
+
+    // (Timer1 may have been already switched to high resolution by the
+    // other pin, in which case this one follows suit)
+    if(timer1 && (bits > 8 || t1Bits > 8) && setupHiRes(bits > 8 ? bits : t1Bits)) {
+        inBits = 12;
+        shift  = 12 - t1Bits;
+    } else
+    if(bits > 8) {
+    #ifdef USE_PWM_DITHER
+        // Dither ticks: SysTick for Timer0, the overflow for Timer1/2
+        uint8_t sreg = SREG;
+        cli();
+        if(tmr == 1) TIMSK1 |= _BV(TOIE1);
+        #if defined(TIMSK2) && !defined(USE_SOFT_PWM)
+        if(tmr == 2) TIMSK2 |= _BV(TOIE2);
+        #endif
+        SREG = sreg;
+        if(tmr <= 2) {
+            inBits = 12;
+            shift  = 4;
+            dither = true;
+        }
+    #endif
+    }
+
+    // Connect the pin to the timer, starting from 0%
+    inverted = false;
+    write(0);
+    *tccr |= comNorm;
+#endif
+}
+
+bool PwmOut::
+setupHiRes(uint8_t bits)
+{
+#if defined(ARDUINO_ARCH_AVR) && defined(USE_HIRES_PWM)
+    if(bits > 12) bits = 12;
+    if(bits < 10) bits = 10;
+    if(t1Bits == 8) {
+        // Phase-correct PWM, TOP = ICR1 (mode 10), no prescaler
+        uint8_t sreg = SREG;
+        cli();
+        TCCR1B = 0;
+        TCCR1A = (TCCR1A & ~(_BV(WGM10) | _BV(WGM11))) | _BV(WGM11);
+        ICR1   = (1U << bits) - 1;
+        TCNT1  = 0;
+        TCCR1B = _BV(WGM13) | _BV(CS10);
+        SREG = sreg;
+        t1Bits = bits;
+    }
+    return true;
+#else
+    (void)bits;
+    return false;
+#endif
+}
+
+void PwmOut::
+setInverted(bool inv)
+{
+#ifdef ARDUINO_ARCH_AVR
+    if(inv == inverted) return;
+    inverted = inv;
+    uint8_t sreg = SREG;
+    cli();
+    if(inv) *tccr |= comInv; else *tccr &= ~comInv;
+    SREG = sreg;
+#endif
+}
+
+void PwmOut::
+writeOcr(uint16_t val)
+{
+#ifdef ARDUINO_ARCH_AVR
+    if(kind == T16) {
+        uint8_t sreg = SREG;
+        cli();
+        *(volatile uint16_t *)ocr = val;   // TEMP register is shared
+        SREG = sreg;
+    } else {
+        *(volatile uint8_t *)ocr = (uint8_t)val;
+    }
+#else
+    (void)val;
+#endif
+}
+
+void PwmOut::
+write(uint16_t val)
+{
+    uint8_t frac = (dither ? (val & 0x0F) : 0);
+    val >>= shift;
+
+#ifdef USE_SOFT_PWM
+    if(kind == SOFT) {
+        SoftPwm::write(slot, (uint8_t)val);
+        return;
+    }
+#endif
+#ifdef ARDUINO_ARCH_AVR
+    if(kind != NONE) {
+        if(fastPwm) {
+            // 0% = inverted 100%
+            setInverted((val == 0) && (frac == 0));
+            if(inverted) val = 255;
+        }
+        if(val >= 255) frac = 0;
+        ditOn   = false;
+        ditBase = (uint8_t)val;
+        ditFrac = frac;
+        writeOcr(val);
+        ditOn   = (frac != 0);
+        return;
+    }
+#endif
+    if(val == 0) {
+        digitalWrite(pin, 0);
+    } else
+    if(val == 255) {
+        digitalWrite(pin, 1);
+    } else {
+        analogWrite(pin, val);
+    }
+}
+
+#if defined(ARDUINO_ARCH_AVR) && defined(USE_PWM_DITHER)
+// Phase-correct timers take a new compare value at TOP only: the dither
+// steps at BOTTOM, once per period
+ISR(TIMER1_OVF_vect)
+{
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) {
+        chan[ch].out.ditherTick(1);
+    }
+}
+
+#if defined(TIMSK2) && !defined(USE_SOFT_PWM)
+ISR(TIMER2_OVF_vect)
+{
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) {
+        chan[ch].out.ditherTick(2);
+    }
+}
+#endif
+#endif
+
+// end PwmOut.cpp
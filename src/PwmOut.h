@@ -0,0 +1,115 @@
+// =======================================================================
+// @file        PwmOut.h
+//
+// @project     NanoPWM
+// @details     Direct timer-register PWM output
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __PWMOUT__H__
+#define __PWMOUT__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// The pin is resolved to its compare register (OCRnx) and COM bits once,
+// in begin(); write() then just stores the compare value, instead of going
+// through analogWrite()'s pin-to-timer lookup on every call.
+//
+// 0% and 100% are obtained without disconnecting the pin from the timer
+// (which is what analogWrite()/digitalWrite() do, and glitches when the
+// timer is reconnected):
+// - phase-correct PWM (Timer1/2/3 as set up by the core): OCR=0 and
+//   OCR=TOP already give a steady low/high output;
+// - fast PWM (Timer0): OCR=TOP gives a steady high, while OCR=0 still
+//   gives a narrow spike; 0% is then obtained by switching the output to
+//   inverting mode with OCR=TOP.
+// Pins on timers not handled here (or non-AVR builds) fall back to
+// analogWrite().
+// With USE_SOFT_PWM, Timer2 pins and pins with no timer at all are driven
+// by SoftPwm instead.
+//
+// Resolution: an output is driven with either 8-bit or 12-bit values
+// (see bits()). 12-bit values are obtained by requesting more than 8 bits
+// in begin(), and are realized as:
+// - USE_HIRES_PWM:  Timer1 pins switch Timer1 to phase-correct PWM with
+//                   TOP=ICR1 and no prescaler, with the requested 10..12
+//                   bit resolution (1.95 kHz at 12 bit, 7.8 kHz at 10 bit
+//                   @ 16 MHz). Both OC1A/OC1B share the setting.
+// - USE_PWM_DITHER: other pins keep 8-bit compare values, and the 4 extra
+//                   bits are spread over 16 PWM periods by adding one LSB
+//                   on the right fraction of periods (ditherTick()). The
+//                   compare value is taken once per period (at BOTTOM in
+//                   fast PWM, at TOP in phase-correct), so the dither is
+//                   stepped once per period of the pin's own timer: from
+//                   SysTick for Timer0 (976 Hz), from the overflow
+//                   interrupt for Timer1/Timer2 (490 Hz). Pins on other
+//                   timers stay at 8 bits.
+
+// Output resolution requested for all channels
+#if defined(USE_HIRES_PWM) || defined(USE_PWM_DITHER)
+    #ifndef PWM_BITS
+    #define PWM_BITS    12
+    #endif
+#else
+    #undef  PWM_BITS
+    #define PWM_BITS    8
+#endif
+
+class PwmOut
+{
+    enum : uint8_t { NONE = 0, T8, T16, SOFT };
+
+    volatile void    *ocr;      // Compare register (8 or 16 bit)
+    volatile uint8_t *tccr;     // Register holding the COM bits
+    uint8_t           comInv;   // COMnx0: set = inverting mode
+    uint8_t           kind;
+    uint8_t           tmr;      // Timer number (dither tick source)
+    bool              fastPwm;
+    bool              inverted;
+    uint8_t           pin;
+    uint8_t           slot;     // SoftPwm slot
+    uint8_t           inBits;   // Resolution of values passed to write()
+    uint8_t           shift;    // value >> shift = compare value
+    bool              dither;   // Bits shifted out are dithered
+
+    // Dithering state (shared with the SysTick ISR)
+    volatile bool     ditOn;
+    volatile uint8_t  ditBase;
+    volatile uint8_t  ditFrac;
+    uint8_t           ditAcc;
+
+    static uint8_t    t1Bits;   // Timer1 resolution (8 = core default)
+
+    void    setInverted(bool inv);
+    void    writeOcr(uint16_t val);
+    bool    setupHiRes(uint8_t bits);
+
+public:
+    PwmOut(void);
+
+    /// <bits> is the resolution requested; check bits() for the one obtained
+    void    begin(uint8_t Ppin, uint8_t bits = 8);
+    void    write(uint16_t val);
+    bool    isDirect(void)  { return (kind != NONE); }
+    uint8_t bits(void)      { return inBits; }
+
+    /// Called once per PWM period of timer <t> (from SysTick for Timer0,
+    /// from the Timer1/Timer2 overflow ISRs)
+    void    ditherTick(uint8_t t)
+    {
+        if(!ditOn || t != tmr) return;
+        uint8_t v = ditBase;
+        ditAcc += ditFrac;
+        if(ditAcc & 0x10) {
+            ditAcc &= 0x0F;
+            v++;
+        }
+        writeOcr(v);
+    }
+};
+
+#endif  //!__PWMOUT__H__
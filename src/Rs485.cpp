@@ -0,0 +1,59 @@
+// =======================================================================
+// @file        Rs485.cpp
+//
+// @project     NanoPWM
+// @details     RS-485 transceiver driver-enable control
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Rs485.h"
+#include "main.h"
+
+#ifdef USE_RS485
+
+namespace Rs485
+{
+    volatile uint8_t *dePort;
+    uint8_t           deMask;
+
+    void begin(void)
+    {
+        digitalWrite(RS485_DE_PIN, LOW);
+        pinMode(RS485_DE_PIN, OUTPUT);
+        dePort = portOutputRegister(digitalPinToPort(RS485_DE_PIN));
+        deMask = digitalPinToBitMask(RS485_DE_PIN);
+    }
+
+    void txEnable(void)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        *dePort |= deMask;
+        // Clear any stale completion: TXC0 is cleared by writing a one, so
+        // write it alone, keeping only the mode bits (a read-modify-write
+        // would also write back the FE0/DOR0/UPE0 flags)
+        UCSR0A  = _BV(TXC0) | (UCSR0A & (_BV(U2X0) | _BV(MPCM0)));
+        SREG = sreg;
+    }
+
+    void poll(void)
+    {
+        // All sent: nothing left in the buffer (UDRE interrupt off) and
+        // the shift register empty
+        if((*dePort & deMask) && (UCSR0A & _BV(TXC0)) && !(UCSR0B & _BV(UDRIE0))) {
+            // Port shared with ISR-driven pins (soft PWM): no interrupt
+            // between the read and the write back
+            uint8_t sreg = SREG;
+            cli();
+            *dePort &= ~deMask;
+            SREG = sreg;
+        }
+    }
+}
+
+#endif  //USE_RS485
+
+// end Rs485.cpp
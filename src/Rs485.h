@@ -0,0 +1,42 @@
+// =======================================================================
+// @file        Rs485.h
+//
+// @project     NanoPWM
+// @details     RS-485 transceiver driver-enable control
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __RS485__H__
+#define __RS485__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Half-duplex bus: the driver is enabled (DE high; /RE usually tied to it)
+// by txEnable() right before a reply is queued to Serial, and released by
+// poll() from the main loop once the UART reports transmit complete (the
+// stop bit of the last char sent). The TXC flag is polled rather than
+// used as an interrupt, as the core's Serial.flush() relies on it.
+// Only nodes addressed individually ever reply, so the bus has a single
+// talker at a time; the master should allow for a turnaround of 1 ms
+// after a reply before sending again.
+//
+// Hardware UART0 only (Nano); DE pin set by RS485_DE_PIN (default D2).
+
+namespace Rs485
+{
+#ifdef USE_RS485
+    void    begin(void);
+    void    txEnable(void);
+    void    poll(void);
+#else
+    inline void begin(void)     {}
+    inline void txEnable(void)  {}
+    inline void poll(void)      {}
+#endif
+}
+
+#endif  //!__RS485__H__
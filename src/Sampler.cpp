@@ -0,0 +1,75 @@
+// =======================================================================
+// @file        Sampler.cpp
+//
+// @project     NanoPWM
+// @details     Fixed-rate, tick-driven sampler for the channel inputs
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "Sampler.h"
+#include "main.h"
+#include "AdcEngine.h"
+
+#ifdef  USE_SAMPLER
+
+namespace Sampler
+{
+    RingBuf<Sample, RingSize> ring;
+
+    volatile uint8_t    rate    = SMP_RATE;
+    uint8_t             rateCnt = 1;
+    uint8_t             lateCnt = 0;
+
+    static void push(uint8_t ch, uint16_t val)
+    {
+        ring.push(Sample{ch, val});
+    }
+
+    void begin(void)
+    {
+        ring.flush();
+        AdcEngine::begin(false, push);
+    }
+
+    void setRate(uint8_t ticks)
+    {
+        rate = (ticks ? ticks : 1);
+    }
+
+    uint8_t getRate(void)
+    {
+        return rate;
+    }
+
+    void tick(void)
+    {
+        if(--rateCnt) return;
+        rateCnt = rate;
+        // A full sweep takes ~110us per channel, well below a tick
+        if(!AdcEngine::startSweep()) {
+            if(lateCnt != 0xFF) lateCnt++;
+        }
+    }
+
+    bool pop(Sample &s)
+    {
+        return ring.pop(s);
+    }
+
+    uint8_t overruns(void)
+    {
+        return ring.dropped();
+    }
+
+    uint8_t late(void)
+    {
+        return lateCnt;
+    }
+}
+
+#endif  //USE_SAMPLER
+
+// end Sampler.cpp
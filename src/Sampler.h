@@ -0,0 +1,58 @@
+// =======================================================================
+// @file        Sampler.h
+//
+// @project     NanoPWM
+// @details     Fixed-rate, tick-driven sampler for the channel inputs
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __SAMPLER__H__
+#define __SAMPLER__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <RingBuf.h>
+
+// The sampler runs in the SysTick ISR: every <rate> ticks it starts an
+// AdcEngine sweep over all channels; each result is pushed to the ring
+// straight from the ADC interrupt (so no ISR ever waits for the ADC).
+// Each channel is therefore sampled every
+//    rate * SysTick::TICK_US
+// regardless of what the main loop is doing (2.05 ms at rate 2).
+
+#ifndef SMP_RATE
+#define SMP_RATE    2       // Ticks between samples
+#endif
+
+struct Sample
+{
+    uint8_t     ch;
+    uint16_t    val;
+};
+
+namespace Sampler
+{
+    constexpr uint8_t RingSize = 32;
+
+    /// Reads ADC pins from chan[]: call after channels have been set
+    void    begin(void);
+    void    setRate(uint8_t ticks);
+    uint8_t getRate(void);
+
+    /// Called from SysTick ISR
+    void    tick(void);
+
+    /// Called from main loop; returns false if no sample pending
+    bool    pop(Sample &s);
+
+    /// Samples lost because the main loop didn't keep up
+    uint8_t overruns(void);
+
+    /// Ticks skipped because the previous sweep was still running
+    uint8_t late(void);
+}
+
+#endif  //!__SAMPLER__H__
@@ -0,0 +1,201 @@
+// =======================================================================
+// @file        SoftPwm.cpp
+//
+// @project     NanoPWM
+// @details     Timer-interrupt software PWM on arbitrary GPIOs
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "SoftPwm.h"
+#include "main.h"
+
+#if defined(USE_SOFT_PWM) && defined(ARDUINO_ARCH_AVR)
+
+namespace SoftPwm
+{
+    struct Edge
+    {
+        uint8_t t;                  // Timer count at which to clear
+        uint8_t clr[MaxPorts];      // Masks of bits to clear, per port
+    };
+
+    struct EdgeList
+    {
+        Edge    edge[MaxSlots];
+        uint8_t set[MaxPorts];      // Bits to set at period start, per port
+        uint8_t n;
+    };
+
+    // Slot setup
+    volatile uint8_t   *portReg[MaxPorts];
+    uint8_t             portMask[MaxPorts]; // All soft PWM bits, per port
+    uint8_t             nPorts  = 0;
+    uint8_t             slotPort[MaxSlots];
+    uint8_t             slotMask[MaxSlots];
+    uint8_t             duty[MaxSlots];
+    uint8_t             order[MaxSlots];    // Slots sorted by duty
+    uint8_t             nSlots  = 0;
+
+    // Double-buffered edge lists
+    EdgeList            lists[2];
+    volatile uint8_t    active  = 0;        // List used by the ISR
+    volatile bool       pending = false;    // Back list ready to be swapped in
+    bool                dirty   = false;    // Duties changed since last rebuild
+    bool                held    = false;    // Rebuilds suspended (see hold())
+    uint8_t             ei      = 0;        // Next edge (ISR only)
+
+    static void barrier(void) { __asm__ __volatile__("" ::: "memory"); }
+
+    static void rebuild(void)
+    {
+        EdgeList &l = lists[active ^ 1];
+
+        for(uint8_t p = 0; p < MaxPorts; p++) l.set[p] = 0;
+        l.n = 0;
+        for(uint8_t i = 0; i < nSlots; i++) {
+            uint8_t s = order[i];
+            uint8_t d = duty[s];
+            if(d == 0) continue;
+            l.set[slotPort[s]] |= slotMask[s];
+            if(d == 255) continue;      // Always on: never cleared
+            // Same duty as previous slot: merge into the same edge
+            if(l.n == 0 || l.edge[l.n-1].t != d) {
+                Edge &e = l.edge[l.n++];
+                e.t = d;
+                for(uint8_t p = 0; p < MaxPorts; p++) e.clr[p] = 0;
+            }
+            l.edge[l.n-1].clr[slotPort[s]] |= slotMask[s];
+        }
+        dirty   = false;
+        // The back list must be complete in memory before the ISR can
+        // swap it in
+        barrier();
+        pending = true;
+    }
+
+    void update(void)
+    {
+        // The back list can only be rewritten once the ISR has taken the
+        // previous one; changes made meanwhile are coalesced
+        if(dirty && !pending && !held) rebuild();
+    }
+
+    void hold(bool on)
+    {
+        held = on;
+        if(!on) update();
+    }
+
+    void begin(void)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        // Normal mode, prescaler 64, overflow interrupt
+        TCCR2A = 0;
+        TCCR2B = _BV(CS22);
+        TIMSK2 = _BV(TOIE2);
+        SREG = sreg;
+    }
+
+    int8_t addPin(uint8_t pin)
+    {
+        if(nSlots >= MaxSlots) return -1;
+        uint8_t port = digitalPinToPort(pin);
+        if(port == NOT_A_PORT) return -1;
+        volatile uint8_t *reg = portOutputRegister(port);
+
+        uint8_t p;
+        for(p = 0; p < nPorts; p++) {
+            if(portReg[p] == reg) break;
+        }
+        if(p == nPorts) {
+            if(nPorts >= MaxPorts) return -1;
+            portMask[nPorts] = 0;
+            portReg[nPorts++] = reg;
+        }
+
+        digitalWrite(pin, 0);
+        pinMode(pin, OUTPUT);
+        uint8_t s = nSlots++;
+        slotPort[s] = p;
+        slotMask[s] = digitalPinToBitMask(pin);
+        duty[s]     = 0;
+        portMask[p] |= slotMask[s];
+        order[s]    = s;
+        // Duty 0 is the lowest: move to the front of the order
+        for(uint8_t i = s; i > 0 && duty[order[i-1]] > 0; i--) {
+            order[i]   = order[i-1];
+            order[i-1] = s;
+        }
+        return (int8_t)s;
+    }
+
+    void write(uint8_t slot, uint8_t d)
+    {
+        if(slot >= nSlots || duty[slot] == d) return;
+        duty[slot] = d;
+
+        // Incremental update: move the slot to its new place in the order
+        uint8_t i = 0;
+        while(order[i] != slot) i++;
+        while(i > 0 && duty[order[i-1]] > d) {
+            order[i] = order[i-1]; order[--i] = slot;
+        }
+        while(i < nSlots-1 && duty[order[i+1]] < d) {
+            order[i] = order[i+1]; order[++i] = slot;
+        }
+        dirty = true;
+        update();
+    }
+}
+
+using namespace SoftPwm;
+
+// Clear the outputs of edges already due; program the compare for the
+// next one. An edge closer than 2 timer counts (8us) is applied at once,
+// as the compare match might be missed (so the shortest pulses may be up
+// to 2 LSB off).
+static inline void runEdges(const EdgeList &l)
+{
+    while(ei < l.n) {
+        const Edge &e = l.edge[ei];
+        if((uint16_t)TCNT2 + 2 < e.t) {
+            OCR2A   = e.t;
+            TIFR2   = _BV(OCF2A);
+            TIMSK2 |= _BV(OCIE2A);
+            // Counter may have passed the value while it was being set
+            if(TCNT2 < e.t) return;
+        }
+        for(uint8_t p = 0; p < nPorts; p++) {
+            if(e.clr[p]) *portReg[p] &= ~e.clr[p];
+        }
+        ei++;
+    }
+    TIMSK2 &= ~_BV(OCIE2A);
+}
+
+ISR(TIMER2_OVF_vect)
+{
+    if(pending) {
+        active ^= 1;
+        pending = false;
+    }
+    const EdgeList &l = lists[active];
+    for(uint8_t p = 0; p < nPorts; p++) {
+        *portReg[p] = (*portReg[p] & ~portMask[p]) | l.set[p];
+    }
+    ei = 0;
+    runEdges(l);
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+    runEdges(lists[active]);
+}
+
+#endif  //USE_SOFT_PWM
+
+// end SoftPwm.cpp
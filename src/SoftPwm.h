@@ -0,0 +1,52 @@
+// =======================================================================
+// @file        SoftPwm.h
+//
+// @project     NanoPWM
+// @details     Timer-interrupt software PWM on arbitrary GPIOs
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __SOFTPWM__H__
+#define __SOFTPWM__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Sorted-edge scheduler on Timer2 (which is taken over: its hardware PWM
+// pins are driven in software too).
+// Timer2 runs free at F_CPU/64, giving an 8-bit PWM at the same ~976 Hz
+// (@ 16 MHz) of the Timer0 pins. At overflow, all outputs with a non-zero
+// duty are set at once; the compare-A interrupt is then programmed on
+// each distinct duty value in ascending order, and clears all outputs
+// ending there. Outputs are written directly to their port registers, with
+// one precomputed mask per port, so the ISR cost only depends on the
+// number of distinct duties (N+1 interrupts per period at most).
+//
+// The edge list is only rebuilt when a duty changes, in the main context,
+// into a back buffer that the ISR swaps in at the next period start.
+
+namespace SoftPwm
+{
+    constexpr uint8_t MaxSlots = 12;
+    constexpr uint8_t MaxPorts = 3;
+
+    void    begin(void);
+
+    /// Returns the slot for <pin>, or -1 if none available
+    int8_t  addPin(uint8_t pin);
+
+    void    write(uint8_t slot, uint8_t duty);
+
+    /// Call from main loop: applies changes that could not be handed to
+    /// the ISR yet
+    void    update(void);
+
+    /// While held, write() only records duties; on release, all changes
+    /// are handed to the ISR at once (and take effect in the same period)
+    void    hold(bool on);
+}
+
+#endif  //!__SOFTPWM__H__
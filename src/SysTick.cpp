@@ -0,0 +1,54 @@
+// =======================================================================
+// @file        SysTick.cpp
+//
+// @project     NanoPWM
+// @details     Fixed-rate system tick (piggybacks on the millis() timer)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "SysTick.h"
+#include "main.h"
+#ifdef USE_SAMPLER
+#include "Sampler.h"
+#endif
+
+namespace SysTick
+{
+    volatile uint8_t tickCnt = 0;
+
+    void begin(void)
+    {
+#ifdef ARDUINO_ARCH_AVR
+        TIMSK0 |= _BV(OCIE0A);
+#endif
+    }
+
+    uint8_t ticks(void)
+    {
+#ifdef ARDUINO_ARCH_AVR
+        return tickCnt;
+#else
+        return (uint8_t)(micros() / TICK_US);
+#endif
+    }
+}
+
+#ifdef ARDUINO_ARCH_AVR
+ISR(TIMER0_COMPA_vect)
+{
+    SysTick::tickCnt = SysTick::tickCnt + 1;
+#ifdef USE_SAMPLER
+    Sampler::tick();
+#endif
+#ifdef USE_PWM_DITHER
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) {
+        chan[ch].out.ditherTick(0);
+    }
+#endif
+}
+#endif
+
+// end SysTick.cpp
@@ -0,0 +1,33 @@
+// =======================================================================
+// @file        SysTick.h
+//
+// @project     NanoPWM
+// @details     Fixed-rate system tick (piggybacks on the millis() timer)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __SYSTICK__H__
+#define __SYSTICK__H__
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// The tick is the Timer0 compare-A interrupt. Timer0 is left untouched
+// (it keeps running millis() and the PWM on OC0A/OC0B): whatever the value
+// of OCR0A, a compare match occurs exactly once per timer cycle, so the
+// tick rate is the Timer0 overflow rate (976.5 Hz @ 16 MHz).
+
+namespace SysTick
+{
+    constexpr uint16_t TICK_US = (uint16_t)((64UL * 256UL * 1000000UL) / F_CPU);
+
+    void    begin(void);
+
+    /// Free-running tick counter (wraps every 256 ticks)
+    uint8_t ticks(void);
+}
+
+#endif  //!__SYSTICK__H__
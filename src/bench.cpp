@@ -0,0 +1,192 @@
+// =======================================================================
+// @file        bench.cpp
+//
+// @project     NanoPWM
+// @details     On-target profiling of the control loop hot path
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include "bench.h"
+
+#ifdef  PROFILE
+
+#include "serialCmd.h"
+#include "BinCmd.h"
+#include "crc8.h"
+#include <ExpFilter.h>
+#ifdef USE_SOFT_PWM
+#include "SoftPwm.h"
+#endif
+
+constexpr uint16_t BenchCalls = 256;
+
+static uint32_t     loopSum  = 0;
+static uint16_t     loopCnt  = 0;
+static uint16_t     loopMin  = 0xFFFF;
+static uint16_t     loopMax  = 0;
+static bool         skipPass = false;
+
+static volatile uint16_t sink;
+static ExpFilter<int>    benchFilter(30, 0);
+static ExpFilterQ<2, uint16_t, uint16_t> benchFilterQ(0);
+static Channel::InFilter benchInFilter;
+static Channel           benchChan;     // procInVal() would upset ch. #0's filter
+
+void benchLoopPass(unsigned long us)
+{
+    if(skipPass) {
+        skipPass = false;
+        return;
+    }
+    uint16_t t = (us > 0xFFFF ? 0xFFFF : (uint16_t)us);
+    if(loopCnt == 0xFFFF) return;
+    loopCnt++;
+    loopSum += t;
+    if(t < loopMin) loopMin = t;
+    if(t > loopMax) loopMax = t;
+}
+
+static void printRow(const __FlashStringHelper *name, uint16_t calls, uint32_t cycles)
+{
+    Serial.print(name);
+    Serial.print(',');
+    Serial.print(calls);
+    Serial.print(',');
+    Serial.println(cycles);
+}
+
+static uint32_t toCycles(unsigned long us, uint16_t calls, uint32_t overhead)
+{
+    uint32_t c = ((uint32_t)us * clockCyclesPerMicrosecond()) / calls;
+    return (c > overhead ? c - overhead : 0);
+}
+
+void printBench(void)
+{
+    unsigned long t0;
+    uint16_t      i;
+    uint32_t      ovh;
+    Channel      &ch   = chan[0];
+    uint8_t       bakV = ch.getVal();
+    bool          bakI = ch.internal;
+
+    Serial.println(F("kernel,calls,cycles"));
+
+    // Bare loop overhead, subtracted from all kernels
+    t0 = micros();
+    for(i = 0; i < BenchCalls; i++) sink = i;
+    ovh = toCycles(micros() - t0, BenchCalls, 0);
+    printRow(F("overhead"), BenchCalls, ovh);
+
+#ifndef USE_ADC_ISR
+    // analogRead() would clash with the interrupt-driven ADC
+    t0 = micros();
+    for(i = 0; i < BenchCalls; i++) sink = ch.fetchInVal();
+    printRow(F("fetchInVal"), BenchCalls, toCycles(micros() - t0, BenchCalls, ovh));
+#endif
+
+    t0 = micros();
+    for(i = 0; i < BenchCalls; i++) sink = benchChan.procInVal(i << 2);
+    printRow(F("procInVal"), BenchCalls, toCycles(micros() - t0, BenchCalls, ovh));
+
+    t0 = micros();
+    for(i = 0; i < BenchCalls; i++) { ch.setVal((uint8_t)i); sink = i; }
+    printRow(F("setVal"), BenchCalls, toCycles(micros() - t0, BenchCalls, ovh));
+
+    t0 = micros();
+    for(i = 0; i < BenchCalls; i++) { benchFilter.Filter(i << 2); sink = i; }
+    printRow(F("ExpFilter"), BenchCalls, toCycles(micros() - t0, BenchCalls, ovh));
+    sink = benchFilter.Current();
+
+    t0 = micros();
+    for(i = 0; i < BenchCalls; i++) { benchFilterQ.Filter(i << 2); sink = i; }
+    printRow(F("ExpFilterQ"), BenchCalls, toCycles(micros() - t0, BenchCalls, ovh));
+    sink = benchFilterQ.Current();
+
+    t0 = micros();
+    for(i = 0; i < BenchCalls; i++) sink = benchInFilter.apply(i << 2);
+    printRow(F("InFilter"), BenchCalls, toCycles(micros() - t0, BenchCalls, ovh));
+
+    // Full command, fed one char at a time as from Serial
+    setCmdQuiet(true);
+    t0 = micros();
+    for(i = 0; i < BenchCalls; i++) {
+        feedCmdChar('V'); feedCmdChar('0');
+        feedCmdChar('1'); feedCmdChar('2'); feedCmdChar('8');
+        sink = i;
+    }
+    printRow(F("cmdFrame"), BenchCalls, toCycles(micros() - t0, BenchCalls, ovh));
+    setCmdQuiet(false);
+
+    // Binary frame with all channel values, byte by byte
+    {
+        uint8_t frm[MAX_CH + 4];
+        frm[0] = BinCmd::SYNC;
+        frm[1] = BinCmd::T_VALUES;
+        frm[2] = MAX_CH;
+        for(uint8_t c = 0; c < MAX_CH; c++) frm[3+c] = 128;
+        frm[MAX_CH+3] = crc8(&frm[1], MAX_CH+2);
+        uint8_t bakVals[MAX_CH];
+        bool    bakInt[MAX_CH];
+        for(uint8_t c = 0; c < MAX_CH; c++) {
+            bakVals[c] = chan[c].PWMval;
+            bakInt[c]  = chan[c].internal;
+        }
+        uint8_t bakAck = BinCmd::getAckMode();
+        BinCmd::setAckMode(BinCmd::ACK_NONE);
+        t0 = micros();
+        for(i = 0; i < BenchCalls; i++) {
+            for(uint8_t b = 0; b < sizeof(frm); b++) BinCmd::feed(frm[b]);
+            sink = i;
+        }
+        printRow(F("binFrame"), BenchCalls, toCycles(micros() - t0, BenchCalls, ovh));
+        BinCmd::setAckMode(bakAck);
+        for(uint8_t c = 0; c < MAX_CH; c++) {
+            chan[c].internal = bakInt[c];
+            chan[c].setVal(bakVals[c]);
+        }
+    }
+
+    ch.internal = bakI;
+    ch.setVal(bakV);
+
+#ifdef USE_SOFT_PWM
+    // Soft PWM ISR load: time a busy loop loses to the Timer2 interrupts,
+    // per PWM period (1024us). Outputs freeze for the reference run.
+    {
+        const uint16_t Spins = 32768;
+        unsigned long  tOn, tOff;
+        uint8_t        msk = TIMSK2;
+
+        t0 = micros();
+        for(i = 0; i < Spins; i++) sink = i;
+        tOn = micros() - t0;
+        TIMSK2 = 0;
+        t0 = micros();
+        for(i = 0; i < Spins; i++) sink = i;
+        tOff = micros() - t0;
+        TIMSK2 = msk;
+        uint16_t periods = (uint16_t)((tOn >> 10) ? (tOn >> 10) : 1);
+        printRow(F("softPwmIsr"), periods, toCycles((tOn > tOff ? tOn - tOff : 0), periods, 0));
+    }
+#endif
+
+    // Loop pass stats since last report
+    if(loopCnt) {
+        printRow(F("loop_avg"), loopCnt, (loopSum * clockCyclesPerMicrosecond()) / loopCnt);
+        printRow(F("loop_min"), loopCnt, (uint32_t)loopMin * clockCyclesPerMicrosecond());
+        printRow(F("loop_max"), loopCnt, (uint32_t)loopMax * clockCyclesPerMicrosecond());
+    }
+    loopSum  = 0;
+    loopCnt  = 0;
+    loopMin  = 0xFFFF;
+    loopMax  = 0;
+    skipPass = true;    // This pass is dominated by the report itself
+}
+
+#endif  //PROFILE
+
+// end bench.cpp
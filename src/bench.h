@@ -0,0 +1,30 @@
+// =======================================================================
+// @file        bench.h
+//
+// @project     NanoPWM
+// @details     On-target profiling of the control loop hot path
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __BENCH__H__
+#define __BENCH__H__
+
+#include "main.h"
+
+#ifdef PROFILE
+
+// Account for one loop() pass lasting <us> microseconds
+void benchLoopPass(unsigned long us);
+
+// Run each kernel in a tight loop and print the result as CSV:
+//   kernel,calls,cycles
+// where <cycles> is the average per call, net of the loop overhead.
+// micros() has a 4us (64 cycles) granularity, hence the averaging.
+void printBench(void);
+
+#endif  //PROFILE
+
+#endif  //!__BENCH__H__
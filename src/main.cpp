@@ -15,13 +15,40 @@
 
 #include "main.h"
 #include "serialCmd.h"
+#include "SysTick.h"
+#include "Baud.h"
+#include "Rs485.h"
+#include "Fader.h"
+#include "Player.h"
+#include "Budget.h"
+#ifdef USE_SAMPLER
+#include "Sampler.h"
+#endif
+#ifdef USE_ADC_ISR
+#include "AdcEngine.h"
+#endif
+#ifdef USE_SOFT_PWM
+#include "SoftPwm.h"
+#endif
+#ifdef USE_DMX
+#include "Dmx.h"
+#include "Latch.h"
+#endif
+#ifdef PROFILE
+#include "bench.h"
+#endif
 
-#define UART_BAUD       19200
+// Unit tests have setup()/loop() of their own: the firmware's are run
+// from there (see main.h)
+#ifdef PIO_UNIT_TESTING
+#define setup   appSetup
+#define loop    appLoop
+#endif
 
 //#define USE_I2C
 
 #ifdef  USE_I2C
-#include <Wire.h>
+#include "I2cRegs.h"
 #define I2C_ADDRESS     0x01
 #endif
 
@@ -35,133 +62,173 @@ unsigned long     last_1s  = 0;
 
 Channel           chan[MAX_CH];
 EEconfig          cfgStore;
-
-constexpr uint8_t CfgBlockSize = MAX_CH * Channel::cfgSize;
-
-#ifdef  USE_I2C
-volatile bool     I2CReqPending = false;
-#endif
+uint8_t           baudSel  = Baud::Default;
+uint16_t          dmxAddr  = 1;
+uint8_t           nodeAddr = 0;
+
+// Config block: a sequence of TLV items (tag, length, value), so that
+// items can be added without breaking older records: unknown tags are
+// skipped, and items missing from a record keep their defaults.
+// Per-channel items hold one byte per channel, from #0 on (a record from
+// a build with a different channel count loads what it can).
+enum CfgTag : uint8_t {
+    TAG_GLOBAL  = 0x01,     // baudSel, dmxAddr (LSB first), nodeAddr
+    TAG_BUDGET  = 0x02,     // Power budget (0.1 A, LSB first)
+    TAG_FLAGS   = 0x10,     // Channel::pack()
+    TAG_VALUE   = 0x11,     // Setpoints
+    TAG_WEIGHT  = 0x12,     // Input filter weights
+    TAG_CURVE   = 0x13,     // Brightness curves (Curves::Id)
+    TAG_POINTS  = 0x14,     // Custom curve breakpoints, as x,y pairs
+    TAG_MAXCUR  = 0x15,     // Max currents (0.1 A)
+};
+constexpr uint8_t CfgBlockSize = (2 + 4) + (2 + 2) + 5 * (2 + MAX_CH) + (2 + 2 * Curves::MaxPoints);
+static_assert(Channel::cfgSize == 1, "TAG_FLAGS holds one byte per channel");
+// Layout version of the config block; bump on incompatible changes, and
+// convert older layouts in fetchParams()
+constexpr uint8_t CfgVersion   = 2;
+// Config store: 8 slots at the bottom of the EEPROM (with room for
+// layouts to grow without moving slots)
+constexpr uint8_t  CfgSlotSize = EEconfig::MaxSlot;
+constexpr uint16_t CfgEESize   = 8 * CfgSlotSize;
+static_assert(CfgBlockSize + EEconfig::Overhead <= CfgSlotSize, "Config block too large");
+static_assert(CfgEESize <= Player::EEBase, "Config store overlaps the user script area");
 
 // ===============================
-//  Demo functions
+//  Main functions
 // ===============================
 
-// "Plays" a ramp (0->100%->0) on the channels specified in <pattern>
-//  Returns 0 when finished, or 1 if interrupted by a serial or I2C message
-// (whether valid or not).
-
-constexpr uint8_t RAMP_DLY = 4;
-
-//static
-uint8_t demo_stepChannel(uint8_t pattern) 
+static uint8_t *putTag(uint8_t *dst, uint8_t tag, uint8_t len)
 {
-    uint8_t res = 0;
-    uint8_t m   = 0x01;
-    uint8_t bakVals[MAX_CH];
-
-    // Expects queue to be flushed at entry.
-    // (Also be mindful of upcoming CR/LF from last/current message)
-    if(Serial.available()) return 1;
-#ifdef  USE_I2C
-    if(I2CReqPending) return 1;
-#endif
-
-    // Save (all) current channel values and start relevant ones from 0
-    for(uint8_t ch = 0; ch<MAX_CH; ch++, m <<= 1) {
-        if(!(pattern & m)) continue;
-        bakVals[ch] = chan[ch].getVal();
-        chan[ch].setVal(0);
-    }
-
-    // Ramp all involved channels
-    for(uint16_t dt = 0; (dt < 512) && (res == 0); dt++) {
-        uint8_t v = dt & 0xFF;
-        if(dt > 255) v = 255-v; 
-        m = 0x01;
-        for(uint8_t ch = 0; ch<MAX_CH; ch++, m <<= 1) {
-            if(pattern & m) chan[ch].setVal(v);
-        }
-
-        // Check exit conditions
-        if(Serial.available())  res = 1;
-#ifdef  USE_I2C
-        if(I2CReqPending)  res = 1;
-#endif
-
-        // Speed delay
-        delay(RAMP_DLY); 
-    }
-
-    // Restore channel values (modified only)
-    m = 0x01;
-    for(uint8_t ch = 0; ch<MAX_CH; ch++, m <<= 1) {
-        if(!(pattern & m)) continue;
-        chan[ch].setVal(bakVals[ch]);
-    }
-    
-    return res;
+    *dst++ = tag;
+    *dst++ = len;
+    return dst;
 }
 
-uint8_t demo_stepAll(bool repeat) 
-{
-    uint8_t res = 0;
-    while(((res = demo_stepChannel(0xFF)) == 0) && repeat);
-    return res;
-}
-
-uint8_t demo_stepSeq(bool repeat) 
-{
-    uint8_t res = 0;
-    do {
-        for(uint8_t i = 0; (i < MAX_CH) && (res == 0) ; i++) {
-            res = demo_stepChannel(1<<i);
-        }
-    } while((res == 0) && repeat);
-    return res;
-}
-
-
-// ===============================
-//  Main functions
-// ===============================
-
 void saveParams(void)
 {
     uint8_t  buf[CfgBlockSize];
     uint8_t *dst = buf;
 
+    dst = putTag(dst, TAG_GLOBAL, 4);
+    *dst++ = baudSel;
+    *dst++ = (uint8_t)(dmxAddr & 0xFF);
+    *dst++ = (uint8_t)(dmxAddr >> 8);
+    *dst++ = nodeAddr;
+
+    dst = putTag(dst, TAG_BUDGET, 2);
+    *dst++ = (uint8_t)(Budget::limit() & 0xFF);
+    *dst++ = (uint8_t)(Budget::limit() >> 8);
+
+    dst = putTag(dst, TAG_FLAGS, MAX_CH);
     for (uint8_t ch = 0; ch < MAX_CH; ch++) {
         dst += chan[ch].pack(dst);
     }
+    dst = putTag(dst, TAG_VALUE, MAX_CH);
+    for (uint8_t ch = 0; ch < MAX_CH; ch++) {
+        *dst++ = chan[ch].PWMval;
+    }
+    dst = putTag(dst, TAG_WEIGHT, MAX_CH);
+    for (uint8_t ch = 0; ch < MAX_CH; ch++) {
+        *dst++ = chan[ch].weight;
+    }
+    // Points before curves, so that loading builds the custom table once
+    uint8_t np = Curves::getPoints(dst + 2);
+    dst = putTag(dst, TAG_POINTS, 2 * np) + 2 * np;
+    dst = putTag(dst, TAG_CURVE, MAX_CH);
+    for (uint8_t ch = 0; ch < MAX_CH; ch++) {
+        *dst++ = chan[ch].curve;
+    }
+    dst = putTag(dst, TAG_MAXCUR, MAX_CH);
+    for (uint8_t ch = 0; ch < MAX_CH; ch++) {
+        *dst++ = chan[ch].maxCur;
+    }
 
-    cfgStore.write(buf);
+    cfgStore.write(buf, (uint8_t)(dst - buf), CfgVersion);
 }
 
-void fetchParams(void)
+static void loadItem(uint8_t tag, const uint8_t *src, uint8_t len)
 {
-    uint8_t  buf[CfgBlockSize];
-    uint8_t *src = buf;
-
-    if (cfgStore.isValid()) {
-        cfgStore.read(buf);
+    uint8_t n = (len < MAX_CH) ? len : MAX_CH;
+    switch (tag) {
+        case TAG_GLOBAL:
+            if (len < 4) break;
+            baudSel  = src[0];
+            dmxAddr  = src[1] | ((uint16_t)src[2] << 8);
+            nodeAddr = src[3];
+            break;
+        case TAG_BUDGET:
+            if (len < 2) break;
+            Budget::setLimit(src[0] | ((uint16_t)src[1] << 8));
+            break;
+        case TAG_FLAGS:
+            for (uint8_t ch = 0; ch < n; ch++) chan[ch].unpack((uint8_t *)&src[ch]);
+            break;
+        case TAG_VALUE:
+            for (uint8_t ch = 0; ch < n; ch++) chan[ch].PWMval = src[ch];
+            break;
+        case TAG_WEIGHT:
+            for (uint8_t ch = 0; ch < n; ch++) chan[ch].setWeight(src[ch]);
+            break;
+        case TAG_POINTS:
+            for (uint8_t i = 0; i + 1 < len; i += 2) {
+                if (!Curves::setPoint(i / 2, src[i], src[i + 1])) break;
+            }
+            break;
+        case TAG_CURVE:
+            for (uint8_t ch = 0; ch < n; ch++) chan[ch].setCurve(src[ch]);
+            break;
+        case TAG_MAXCUR:
+            for (uint8_t ch = 0; ch < n; ch++) chan[ch].setMaxCur(src[ch]);
+            break;
+        default:
+            // Unknown (newer) item
+            break;
+    }
+}
 
-        for (uint8_t ch = 0; ch < MAX_CH; ch++) {
-            chan[ch].unpack(src);
-            src += Channel::cfgSize;
-        }
-    } else {
+void fetchParams(void)
+{
+    uint8_t  buf[EEconfig::MaxSlot];
+    uint8_t  len;
+
+    // (No older layouts to convert yet: version 1 records were in the
+    // smaller slots used before, and are not found by the store)
+    if (!cfgStore.isValid()
+    || cfgStore.version() != CfgVersion
+    || (len = cfgStore.read(buf, sizeof(buf))) > sizeof(buf)) {
         resetParams();
+        return;
+    }
+    defaultParams();
+    const uint8_t *src = buf;
+    const uint8_t *end = buf + len;
+    while (end - src >= 2 && end - src >= 2 + src[1]) {
+        loadItem(src[0], &src[2], src[1]);
+        src += 2 + src[1];
     }
 }
 
-void resetParams(void)
+void defaultParams(void)
 {
     for (uint8_t ch = 0; ch < MAX_CH; ch++) {
         chan[ch].active     = true;
-        chan[ch].internal   = true;
+        chan[ch].internal   = (ch < ADC_CH);
         chan[ch].reverse    = false;
         chan[ch].LEDcorrect = true;
+        chan[ch].setWeight(Channel::DefWeight);
+        chan[ch].setCurve(Curves::CIE);
+        chan[ch].setMaxCur(0);
     }
+    Curves::setPoint(0, 255, 255);
+    Budget::setLimit(0);
+    baudSel = Baud::Default;
+    dmxAddr = 1;
+    nodeAddr = 0;
+}
+
+void resetParams(void)
+{
+    defaultParams();
     saveParams();
 }
 
@@ -220,21 +287,6 @@ bool checkDemo(void)
     return pinVal;
 }
 
-#ifdef  USE_I2C
-void onI2Crequest(void) 
-{
-    I2CReqPending = true;
-    
-    while(Wire.available()) {
-        char c = Wire.read(); // receive byte as a character
-        //int x = Wire.read();    // receive byte as an integer
-
-        //! TODO ........
-    }
-}
-#endif
-
-
 // void TESTsetup() {
 // }
 
@@ -244,60 +296,123 @@ void onI2Crequest(void)
 void setup()
 {
     // TESTsetup();
-    Serial.begin(UART_BAUD);
-
 #ifdef  USE_I2C
-    Wire.begin(I2C_ADDRESS);
-    Wire.onRequest(onI2Crequest);
+    I2cRegs::begin(I2C_ADDRESS);
 #endif
 
     // delay(1000);
+#ifdef  USE_SOFT_PWM
+    SoftPwm::begin();
+#endif
+
+    cfgStore.init(CfgSlotSize, CfgEESize);
+    if (!checkParamReset()) fetchParams();
+#ifndef DMX_ON_UART0
+    // Serial is opened once the rate is known from config
+    // (factory reset restores the default 19200). Auto-baud borrows
+    // Timer1: it runs before the outputs are set up, so D9/D10 are not
+    // disturbed (with AUTO, the fast boot below waits for it).
+    Rs485::begin();
+    Baud::begin(baudSel);
+    deselectNode();
+#endif
+
 #ifdef  HW_V1
     // Hardware v1.x
-    chan[0].set(A0, 3);
-    chan[1].set(A1, 5);
-    chan[2].set(A2, 6);
-    chan[3].set(A3, 9);
+    chan[0].set(A0, 3, PWM_BITS);
+    chan[1].set(A1, 5, PWM_BITS);
+    chan[2].set(A2, 6, PWM_BITS);
+    chan[3].set(A3, 9, PWM_BITS);
     #ifndef PROMINI
-    chan[4].set(A4, 10);
-    chan[5].set(A5, 11);
+    chan[4].set(A4, 10, PWM_BITS);
+    chan[5].set(A5, 11, PWM_BITS);
     #endif
 #else
     // Hardware v2.x
     #ifndef PROMINI
-    chan[0].set(A0, 3);
-    chan[1].set(A1, 5);
-    chan[2].set(A2, 6);
-    chan[3].set(A3, 9);
-    chan[4].set(A6, 10);
-    chan[5].set(A7, 11);
+    chan[0].set(A0, 3, PWM_BITS);
+    chan[1].set(A1, 5, PWM_BITS);
+    chan[2].set(A2, 6, PWM_BITS);
+    chan[3].set(A3, 9, PWM_BITS);
+    chan[4].set(A6, 10, PWM_BITS);
+    chan[5].set(A7, 11, PWM_BITS);
     #else
-    chan[0].set(A0, 5);
-    chan[1].set(A1, 6);
-    chan[2].set(A2, 9);
-    chan[3].set(A3, 10);
+    chan[0].set(A0, 5, PWM_BITS);
+    chan[1].set(A1, 6, PWM_BITS);
+    chan[2].set(A2, 9, PWM_BITS);
+    chan[3].set(A3, 10, PWM_BITS);
     #endif
 #endif  //HW_V1
 
+#ifdef  USE_SOFT_PWM
+    // Extra channels (serial-driven only), on free GPIOs
+    #ifndef PROMINI
+    chan[ADC_CH+0].set(0xFF, 2);
+    chan[ADC_CH+1].set(0xFF, 4);
+    chan[ADC_CH+2].set(0xFF, 7);
+        #ifdef  HW_V1
+    chan[ADC_CH+3].set(0xFF, 8);
+        #else
+    chan[ADC_CH+3].set(0xFF, 12);
+        #endif
+    #endif
+#endif
 
-    cfgStore.init(CfgBlockSize, 128);
-    if (!checkParamReset()) fetchParams();
-
-    if(checkDemo()) {
-        do{
-            if(demo_stepSeq(false)) break;
-            if(demo_stepAll(false)) break;
-        } while(1);
+    // Fast boot: externally driven channels resume their saved setpoint
+    // right away (pot-driven ones follow their input from the first pass)
+    for (uint8_t ch = 0; ch < MAX_CH; ch++) {
+        if (!chan[ch].internal) chan[ch].refresh();
     }
+#ifdef  USE_DMX
+    Dmx::begin(dmxAddr);
+#endif
+
+#if defined(USE_SAMPLER)
+    Sampler::begin();
+#elif defined(USE_ADC_ISR)
+    AdcEngine::begin(true);
+#endif
+    SysTick::begin();
+
+    // Demo runs in background until stopped ("E") or replaced ("D")
+    if(checkDemo()) Player::start(Player::BOOT, true);
 }
 
 void loop()
 {
     // TESTloop();
-    static uint8_t nc = 0;
     static uint8_t v  = 0;
+#ifdef  PROFILE
+    unsigned long t0 = micros();
+#endif
 
     now = millis();
+#ifdef  USE_SAMPLER
+    // Samples are taken at a fixed rate in the tick ISR;
+    // just consume whatever has been collected so far
+    Sample smp;
+    while(Sampler::pop(smp)) {
+        v = chan[smp.ch].procInVal(smp.val);
+        if (chan[smp.ch].internal) {
+            chan[smp.ch].setVal(v);
+        }
+    }
+#elif defined(USE_ADC_ISR)
+    if ((now - lastPoll) > 2) {
+        lastPoll = now;
+        // Conversions run continuously in background:
+        // update every channel with a fresh reading after 2 ms
+        uint16_t aval;
+        for (uint8_t ch = 0; ch < ADC_CH; ch++) {
+            if (!AdcEngine::get(ch, aval)) continue;
+            v = chan[ch].procInVal(aval);
+            if (chan[ch].internal) {
+                chan[ch].setVal(v);
+            }
+        }
+    }
+#else
+    static uint8_t nc = 0;
     if ((now - lastPoll) > 2) {
         lastPoll = now;
         // Update next channel after 2 ms
@@ -306,12 +421,38 @@ void loop()
         if (chan[nc].internal) {
             chan[nc].setVal(v);
         }
-        if (++nc >= MAX_CH) nc = 0;
+        if (++nc >= ADC_CH) nc = 0;
     }
+#endif
     if ((now - last_1s) > 2000) {
         last_1s = now;
         // Serial.println("Tick.");
         // printAllValues();
     }
+#ifdef  USE_DMX
+    // DMX drives all channels (switched to external source, as from
+    // serial); a packet is applied as a whole
+    uint8_t dv[MAX_CH];
+    if(Dmx::read(dv)) {
+        for(uint8_t ch = 0; ch < MAX_CH; ch++) Latch::stage(ch, dv[ch]);
+        Latch::commit();
+    }
+#endif
+#ifndef DMX_ON_UART0
     processCmds(now);
+#endif
+#ifdef  USE_I2C
+    I2cRegs::process();
+#endif
+    Rs485::poll();
+    cfgStore.poll();
+    Player::run();
+    Fader::run();
+    Budget::run();
+#ifdef  USE_SOFT_PWM
+    SoftPwm::update();
+#endif
+#ifdef  PROFILE
+    benchLoopPass(micros() - t0);
+#endif
 }
@@ -15,25 +15,78 @@
 
 #include <Arduino.h>
 #include <stdint.h>
-// #include <avr\pgmspace.h>
+// #include <avr/pgmspace.h>
 // #include "PWMtables.h"
 // #include <average_acc.h>
 // #include <ExpFilter.h>
 #include <EEconfig.h>
-#include "channel.h"
+#include "Channel.h"
 
 // #define PIN_LED 1
 // #define PIN_PWM 1
 // #define PIN_ANA 2
 
+// Sampler, interrupt-driven ADC and soft PWM drive AVR registers directly
+#ifndef ARDUINO_ARCH_AVR
+#undef USE_SAMPLER
+#undef USE_ADC_ISR
+#undef USE_SOFT_PWM
+#undef USE_DMX
+#undef USE_RS485
+#endif
+
+// DMX needs a UART of its own: on the Nano it takes over the only one,
+// and the serial command interface is left out
+#if defined(USE_DMX) && !defined(PROMICRO)
+#define DMX_ON_UART0
+    #ifdef PROFILE
+    #error "PROFILE reports over Serial: not available with USE_DMX on Nano"
+    #endif
+#endif
+
+// RS-485 bus on the hardware UART (Nano only)
+#ifdef USE_RS485
+    #if defined(PROMICRO) || defined(USE_DMX)
+    #error "USE_RS485 needs UART0 for Serial (not available on ProMicro or with DMX)"
+    #endif
+    #ifndef RS485_DE_PIN
+    #define RS485_DE_PIN    2
+    #endif
+    #if defined(USE_SOFT_PWM) && (RS485_DE_PIN == 2 || RS485_DE_PIN == 4 || RS485_DE_PIN == 7)
+    #error "RS485_DE_PIN is used by a soft PWM channel"
+    #endif
+#endif
+
+// The fixed-rate sampler relies on the interrupt-driven ADC
+#if defined(USE_SAMPLER) && !defined(USE_ADC_ISR)
+#define USE_ADC_ISR
+#endif
+
 #ifdef PROMINI
-constexpr uint8_t MAX_CH = 4;
+constexpr uint8_t ADC_CH  = 4;
+#else
+constexpr uint8_t ADC_CH  = 6;
+#endif
+
+// Software PWM adds serial-driven channels (no pot input) on plain GPIOs;
+// they follow the pot-driven ones. Command syntax allows 10 channels max.
+#if defined(USE_SOFT_PWM) && !defined(PROMINI)
+constexpr uint8_t SOFT_CH = 4;
 #else
-constexpr uint8_t MAX_CH = 6;
+constexpr uint8_t SOFT_CH = 0;
 #endif
 
+constexpr uint8_t MAX_CH  = ADC_CH + SOFT_CH;
+static_assert(MAX_CH <= 10, "Channel numbers must be single digits");
+
+// Highest DMX start address: all MAX_CH slots must fit in the universe
+constexpr uint16_t DMX_ADDR_MAX = 512 - MAX_CH + 1;
+
 extern Channel  chan[MAX_CH];
 extern EEconfig cfgStore;
+extern uint8_t  baudSel;    // Baud rate setting (see Baud.h)
+extern uint16_t dmxAddr;    // DMX start address (see Dmx.h)
+extern uint8_t  nodeAddr;   // Bus node address (1..254), 0 = standalone
 
 // uint8_t fetchInVal(uint8_t nCh);
 // void    setVal(uint8_t nCh, uint8_t val);
@@ -42,9 +95,12 @@ extern EEconfig cfgStore;
 void    saveParams(void);
 void    fetchParams(void);
 void    resetParams(void);
+void    defaultParams(void);
 
-uint8_t demo_stepChannel(uint8_t pattern);
-uint8_t demo_stepAll(bool repeat);
-uint8_t demo_stepSeq(bool repeat); 
+#ifdef PIO_UNIT_TESTING
+// Firmware setup()/loop(), renamed in unit test builds
+void    appSetup(void);
+void    appLoop(void);
+#endif
 
 #endif //!__MAIN__H__
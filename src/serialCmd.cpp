@@ -10,68 +10,144 @@
 // =======================================================================
 
 #include "serialCmd.h"
+#include "BinCmd.h"
+#include "Baud.h"
+#include "Latch.h"
+#include "Rs485.h"
+#include "Fader.h"
+#include "Player.h"
+#include "Budget.h"
+#ifdef USE_DMX
+#include "Dmx.h"
+#endif
+#ifdef PROFILE
+#include "bench.h"
+#endif
+
+// The serial interface is not available when DMX takes over the UART
+#ifndef DMX_ON_UART0
+
+// Commands are fixed-length frames; the length is known from the first
+// char through the command table (see CmdTable below), which is only
+// searched at the start of a frame. Chars are then accumulated until the
+// frame is complete, and the handler is run once per command.
+// Received bytes are buffered by the core's Serial RX interrupt.
+// On a bus (node address set), text commands are only run by the node(s)
+// selected with "@nnn", and only a node selected individually replies
+// (commands that only print a report are skipped by the others).
+// Binary frames (see BinCmd.h) start with a non-ASCII sync byte and are
+// routed to BinCmd; a text command interrupted by one is discarded.
+
+// Command flags
+const uint8_t CF_CH     = 0x01;     // msgBuf[1] is a channel number
+const uint8_t CF_CH0    = 0x02;     // msgBuf[0] is a channel number
+const uint8_t CF_NOECHO = 0x04;     // Reply without echoing the cmd char
+const uint8_t CF_ANYNODE= 0x08;     // Run on a bus node even if not selected
+const uint8_t CF_REPORT = 0x10;     // Prints a report: skipped if can't reply
+
+// Handlers get the command char and the channel number (already
+// validated, if CF_CH/CF_CH0); they return false on error.
+typedef bool (*CmdFn)(char cmd, uint8_t chn);
+
+struct CmdDef
+{
+    char    cmd;
+    uint8_t len;        // Frame length, including cmd char
+    uint8_t flags;
+    CmdFn   fn;
+};
 
-const uint8_t  MsgBufLen  = 10;
+const uint8_t  MsgBufLen  = 12;
 const uint16_t MsgTimeout = 10000;
 unsigned long lastCharTS;
 char    msgBuf[MsgBufLen];
 uint8_t ci = 0;
-bool cmdDone;
-bool cmdErr;
-
-void tryCommand(void);
+uint8_t frameLen = 0;       // Length of the frame being received; 0 = none
+CmdDef  curCmd;             // Table entry for the frame being received
+bool cmdQuiet = false;
+uint8_t newBaud = 0xFF;     // Rate change to apply after the reply is sent
+bool    nodeSel = false;    // Node selected by "@nnn" (bus only)
+bool    nodeAll = false;    // Selected by broadcast: run, but never reply
+
+static void runCommand(void);
+static bool findCommand(char c, CmdDef &def);
+
+// Replies are sent only by a standalone node, or by a node selected
+// individually on a bus
+static bool canReply(void)
+{
+    return !cmdQuiet && (nodeAddr == 0 || (nodeSel && !nodeAll));
+}
 
 bool isChannelOK(char c) {
-            return (c >= '0' 
-#ifdef PROMINI
-            && c <= '3');
-#else
-            && c <= '5');
-#endif
+            return (c >= '0' && c < ('0' + MAX_CH));
 }
 
 inline void resetCmd(void)
 {
-    ci = 0;
+    ci       = 0;
+    frameLen = 0;
 }
 
-void flushCmds(void)
+void deselectNode(void)
 {
-    delay(100);
-    while(Serial.available()) Serial.read();
+    nodeSel = false;
+    nodeAll = false;
 }
 
 void processCmds(unsigned long now)
 {
     if(!Serial.available()) {
-        if((now - lastCharTS) > MsgTimeout) ci = 0;
+        if((now - lastCharTS) > MsgTimeout) {
+            resetCmd();
+            BinCmd::reset();
+        }
         return;
     }
     lastCharTS = now;
     while(Serial.available()) {
-        char c = (char)Serial.read();
-        if(c == '\n' || c == '\r') continue;
-        if(c == '#') {
-            ci = 0;
-        } else 
-        if(ci < MsgBufLen) {
-            msgBuf[ci++] = c;
-            tryCommand();
+        uint8_t c = (uint8_t)Serial.read();
+        if(BinCmd::feed(c)) {
+            resetCmd();
+        } else {
+            feedCmdChar((char)c);
         }
     }
 }
 
-bool isValidCommand(uint8_t nChars, bool checkCh = true) {
-    if(ci != nChars) return false;
-    bool res = true;
-    if(checkCh) {
-        if(!(res = isChannelOK(msgBuf[1]))) {
-            // Wrong channel aborts command
-            cmdErr = true;
-            resetCmd();
+void feedCmdChar(char c)
+{
+    if(c == '\n' || c == '\r') return;
+    if(c == '#') {
+        resetCmd();
+        return;
+    }
+    if(frameLen == 0) {
+        // First char of a frame: look up command
+        if(!findCommand(c, curCmd)) {
+            if(canReply()) {
+                Rs485::txEnable();
+                Serial.print(c);
+                Serial.println(" ?");
+            }
+            return;
         }
+        frameLen = curCmd.len;
+    }
+    msgBuf[ci++] = c;
+    if(ci >= frameLen) runCommand();
+}
+
+void setCmdQuiet(bool quiet)
+{
+    cmdQuiet = quiet;
+}
+
+void refreshAll(void)
+{
+    for(uint8_t i = 0; i < MAX_CH; i++) {
+        chan[i].refresh();
     }
-    return res;
 }
 
 inline uint8_t times10(uint8_t v)
@@ -89,23 +165,54 @@ void printHelp(void)
 {
         Serial.println(F("> Values:"));
         Serial.println(F("Vnbbb - Set brightness of channel #n to value bbb"));
+        Serial.println(F("Bnbbb - Stage value bbb for channel #n"));
+        Serial.println(F("L/l   - Apply/discard all staged values at once"));
+        Serial.println(F("Tmmmvvvttttc - Fade ch. in hex mask mmm to vvv in tttt*10ms"));
+        Serial.println(F("        curve c: 0 linear, 1 ease-in, 2 ease-out, 3 ease-in-out"));
         Serial.println(F("O/o   - All channels On/off"));
         Serial.println(F("> Channel setup:"));
         Serial.println(F("An/an - Single channel On/off"));
         Serial.println(F("In/in - Set value source of channel #n to internal/external"));
         Serial.println(F("Rn/rn - Reverse PWM On/Off"));
-        Serial.println(F("Cn/cn - Correct PWM for CIE LED brightness On/Off"));
+        Serial.println(F("Cn/cn - Correct PWM for LED brightness (see J) On/Off"));
         Serial.println(F("nAIRC - Set flags for ch. #n: A/a, I/i, R/r, C/c"));
-        Serial.println(F("s/S   - Save current params"));
+        Serial.println(F("Gnw   - Set input filter weight of ch. #n to 1/2^w (1..6)"));
+        Serial.println(F("Jnc   - Set brightness curve of ch. #n (used if C):"));
+#if CURVE_TABLES > 0
+        Serial.println(F("        0 linear, 1 CIE, 2 gamma 2.2, 3 gamma 2.8, 4 custom"));
+#else
+        Serial.println(F("        0 linear, 1 CIE (gamma/custom: build with CURVE_TABLES)"));
+#endif
+        Serial.println(F("jkxxxyyy - Set custom curve point #k (0..7) to xxx,yyy; drops later ones"));
+        Serial.println(F("fnccc - Set max current of ch. #n to ccc*0.1A (000 = not counted)"));
+        Serial.println(F("qbbbb - Set power budget to bbbb*0.1A (0000 = no limit; see P)"));
+        Serial.println(F("s/S   - Save current params (and setpoints)"));
         Serial.println(F("x/X   - Discard changes, revert to last saved configuration"));
         Serial.println(F("F     - Reset all params to factory defaults"));
         Serial.println(F("p/P   - Report current channel setpoint / parameters"));
-        Serial.println(F("Dn/dn - Demo sequence: D/d continuous/one-shot, 0/1 seq/all"));
+        Serial.println(F("w     - Report output/EEPROM writes / skipped (unchanged)"));
+        Serial.println(F("Kn    - Binary frame acks: 0 none, 1 each, 2 batched"));
+        Serial.println(F("k     - Report binary frame counters"));
+        Serial.println(F("Un    - Baud: 0..6 = 19200,38400,57600,115200,250k,500k,1M; 9 = auto"));
+        Serial.println(F("u     - Report baud rate"));
+        Serial.print(F("Mnnn  - Set DMX start address (001.."));
+        Serial.print(DMX_ADDR_MAX);
+        Serial.println(')');
+        Serial.println(F("m     - Report DMX address / counters"));
+        Serial.println(F("Nnnn  - Set bus node address (001..254; 000 = standalone)"));
+        Serial.println(F("n     - Report bus node address"));
+        Serial.println(F("@nnn  - Select bus node for next commands (255 = all, no replies)"));
+        Serial.println(F("Dn/dn - Play script: D/d continuous/one-shot, 0/1/2 seq/all/user"));
+        Serial.println(F("E     - Stop script"));
+        Serial.println(F("Wooohhhhhhhh - Write 4 bytes (hex) of user script at offset ooo"));
         Serial.println(F("h/H   - Print command help"));
         Serial.println(F("> DEBUG:"));
         Serial.println(F("ynnn  - Print <nnn> bytes from EEPROM (start from current pos)"));
         Serial.println(F("Ynnn  - Print <nnn> bytes from EEPROM (start from 0)"));
         Serial.println(F("Z     - Reset (zero out) EEPROM"));
+#ifdef  PROFILE
+        Serial.println(F("Q     - Profile hot path (cycles per call, CSV)"));
+#endif
 }
 
 void printAllValues(void)
@@ -140,231 +247,562 @@ void printEEpromContent(uint16_t start, uint8_t nvals)
     }
 }
 
-void tryCommand(void)
+// =========================================
+//  Command handlers
+// =========================================
+
+static uint8_t readNum3(const char *p)
 {
-    char    cmd = msgBuf[0];
-    uint8_t chn = msgBuf[1]-'0';
-    cmdDone = false;
-    cmdErr  = false;
-
-    switch(cmd) {
-        case 'v':
-        case 'V':
-        {
-            // "Vnbbb" - set brightness of channel #n to value
-            if(isValidCommand(5)) {
-                chan[chn].internal = false;
-                // if(!chan[chn].internal) {
-                    uint8_t v = (uint8_t)(msgBuf[4]-'0');
-                    v += times10((uint8_t)(msgBuf[3]-'0'));
-                    v += times100((uint8_t)(msgBuf[2]-'0'));
-                    chan[chn].setVal(v);
-                // }
-                cmdDone = true;
-            }
-        }
-        break;
-        
-        case 'o':
-        case 'O':
-        {
-            // "O"/"o"- All channels On/off
-            for(uint8_t i = 0; i < MAX_CH; i++) {
-                chan[chn].active = (cmd == 'O');
-            }           
-            cmdDone = true;
-        }
-        break;
-
-        case 'a':
-        case 'A':
-        {
-            // "An"/"an"- Single channel On/off
-            if(isValidCommand(2)) {
-                chan[chn].active = (cmd == 'A');
-                cmdDone = true;
-            }           
-        }
-        break;
-
-        case 'i':
-        case 'I':
-        {
-            // "In/in"- Set value source of channel #n to internal
-            // (pot reading) or external (serial)
-            if(isValidCommand(2)) {
-                chan[chn].internal = (cmd == 'I');
-                cmdDone = true;
-            }
-        }
-        break;
-
-        case 'r':
-        case 'R':
-        {
-            // "Rn"/"rn"- Reverse PWM On/Off
-            if(isValidCommand(2)) {
-                chan[chn].reverse = (cmd == 'R');
-                cmdDone = true;
-            }
-        }
-        break;
-
-        case 'c':
-        case 'C':
-        {
-            // "Cn"/"cn"- Correct PWM for CIE LED brightness On/Off
-            if(isValidCommand(2)) {
-                chan[chn].LEDcorrect = (cmd == 'C');
-                cmdDone = true;
-            }
-        }
-        break;
-
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-#ifndef PROMINI
-        case '4':
-        case '5':
-#endif  
-        {
-            if(isValidCommand(5, false)) {
-                chn = cmd -'0';
-                chan[chn].active        = (msgBuf[1] == 'A');
-                chan[chn].internal      = (msgBuf[2] == 'I');
-                chan[chn].reverse       = (msgBuf[3] == 'R');
-                chan[chn].LEDcorrect    = (msgBuf[4] == 'C');
-                cmdDone = true;
-            }
-        }
-        break;
-
-        case 's':
-        case 'S':
-        {
-            // "s"/"S"- Save current params
-            saveParams();
-            cmdDone = true;
-        }
-        break;
-
-        case 'x':
-        case 'X':
-        {
-            // "x/X"- Discard changes, revert to last saved configuration
-            fetchParams();
-            cmdDone = true;
-        }
-        break;
+    uint8_t v = (uint8_t)(p[2]-'0');
+    v += times10((uint8_t)(p[1]-'0'));
+    v += times100((uint8_t)(p[0]-'0'));
+    return v;
+}
 
-        case 'F':
-        {
-            // "F"- Reset to factory defaults
-            resetParams();
-            cmdDone = true;
-        }
-        break;
-
-        case 'p':
-        {
-            // "p" - Report current channel values
-            // Reports setpoint value; does not report 0 if inactive
-            for(uint8_t i = 0; i < MAX_CH; i++) {
-                Serial.print("Ch");
-                Serial.print(i);
-                Serial.print(" = ");
-                Serial.println(chan[i].PWMval);
-            }           
-            cmdDone = true;
-        }
-        break;
-
-        case 'P':
-        {
-            // "P" - Report current channel parameters
-            Serial.println(F("Active/Internal/Reverse/Corrected"));
-            for(uint8_t i = 0; i < MAX_CH; i++) {
-                Serial.print(i);
-                Serial.print(chan[i].active     ? ": A " : ": - ");
-                Serial.print(chan[i].internal     ? "I " :   "- ");
-                Serial.print(chan[i].reverse      ? "R " :   "- ");
-                Serial.println(chan[i].LEDcorrect ? "C"  :   "-");
-            }           
-            cmdDone = true;
-        }
-        break;
-
-        case 'd':
-        case 'D':
-        {
-            // "Dn"/"dn"- Demo sequence
-            if(isValidCommand(2,false)) {
-                flushCmds();
-                if(chn == 0) {
-                    demo_stepSeq(cmd == 'D');
-                } else {
-                    demo_stepAll(cmd == 'D');
-                }
-                cmdDone = true;
-            }           
-        }
-        break;
-
-        case 'h':
-        case 'H':
-        case '?':
-        {
-            // "h"/"H"- Print command help
-            printHelp();
-            cmd = ' ';  // Don't print "h" twice
-            cmdDone = true;
-        }
-        break;
-
-        // =========================================
-        //  TEST/DEBUG COMMANDS
-        // =========================================
-
-        case 'y':
-        case 'Y':
-        {
-            // "ynnn" - Print <nnn> bytes from EEPROM (start from current pos)
-            // "Ynnn" - Print <nnn> bytes from EEPROM (start from 0)
-            if(isValidCommand(4)) {
-                uint8_t v = (uint8_t)(msgBuf[3]-'0');
-                v += times10((uint8_t)(msgBuf[2]-'0'));
-                v += times100((uint8_t)(msgBuf[1]-'0'));
-                uint16_t pos = (cmd == 'y' ? cfgStore.getCurrPos() : cfgStore.getBase());
-                printEEpromContent(pos, v);
-                cmdDone = true;
-            }
-        }
-        break;
-
-        case 'Z':
-        {
-            // "Z" - Reset (zero out) EEPROM
-            cfgStore.erase();
-            printEEpromContent(0, 64);
-            cmdDone = true;
+static uint16_t readNum3w(const char *p, bool &ok)
+{
+    uint16_t v = 0;
+    for(uint8_t i = 0; i < 3; i++) {
+        if(p[i] < '0' || p[i] > '9') ok = false;
+        v = v * 10 + (uint8_t)(p[i] - '0');
+    }
+    return v;
+}
+
+static bool cmdValue(char cmd, uint8_t chn)
+{
+    // "Vnbbb" - set brightness of channel #n to value
+    Fader::stop(chn);
+    chan[chn].internal = false;
+    chan[chn].setVal(readNum3(&msgBuf[2]));
+    return true;
+}
+
+static bool cmdStage(char cmd, uint8_t chn)
+{
+    // "Bnbbb" - Stage value for channel #n (applied on "L")
+    Latch::stage(chn, readNum3(&msgBuf[2]));
+    return true;
+}
+
+static bool cmdLatch(char cmd, uint8_t chn)
+{
+    // "L"/"l" - Apply / discard all staged values
+    if(cmd == 'L') {
+        Latch::commit();
+    } else {
+        Latch::discard();
+    }
+    return true;
+}
+
+static int8_t hexDigit(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static bool cmdFade(char cmd, uint8_t chn)
+{
+    // "Tmmmvvvttttc" - Fade channels in mask mmm (hex, bit n = ch. #n)
+    // to value vvv in tttt * 10ms, along curve c
+    uint16_t mask = 0;
+    for(uint8_t i = 1; i < 4; i++) {
+        int8_t h = hexDigit(msgBuf[i]);
+        if(h < 0) return false;
+        mask = (mask << 4) | (uint8_t)h;
+    }
+    bool     ok  = true;
+    uint16_t v   = readNum3w(&msgBuf[4], ok);
+    uint16_t t   = 0;
+    for(uint8_t i = 7; i < 11; i++) {
+        if(msgBuf[i] < '0' || msgBuf[i] > '9') ok = false;
+        t = t * 10 + (uint8_t)(msgBuf[i] - '0');
+    }
+    uint8_t  c   = msgBuf[11] - '0';
+    if(!ok || v > 255 || c >= Fader::NumCurves) return false;
+    if(mask == 0 || (mask >> MAX_CH)) return false;
+    Fader::start(mask, (uint8_t)v, (uint32_t)t * 10, c);
+    return true;
+}
+
+static bool cmdAllOnOff(char cmd, uint8_t chn)
+{
+    // "O"/"o"- All channels On/off
+    for(uint8_t i = 0; i < MAX_CH; i++) {
+        chan[i].active = (cmd == 'O');
+        chan[i].refresh();
+    }           
+    return true;
+}
+
+static bool cmdActive(char cmd, uint8_t chn)
+{
+    // "An"/"an"- Single channel On/off
+    chan[chn].active = (cmd == 'A');
+    chan[chn].refresh();
+    return true;
+}
+
+static bool cmdInternal(char cmd, uint8_t chn)
+{
+    // "In/in"- Set value source of channel #n to internal
+    // (pot reading) or external (serial)
+    chan[chn].internal = (cmd == 'I');
+    return true;
+}
+
+static bool cmdReverse(char cmd, uint8_t chn)
+{
+    // "Rn"/"rn"- Reverse PWM On/Off
+    chan[chn].reverse = (cmd == 'R');
+    chan[chn].refresh();
+    return true;
+}
+
+static bool cmdCorrect(char cmd, uint8_t chn)
+{
+    // "Cn"/"cn"- Correct PWM for LED brightness On/Off
+    chan[chn].LEDcorrect = (cmd == 'C');
+    chan[chn].refresh();
+    return true;
+}
+
+static bool cmdWeight(char cmd, uint8_t chn)
+{
+    // "Gnw" - Set input filter weight of ch. #n to 1/2^w (w = 1..6)
+    return chan[chn].setWeight(msgBuf[2] - '0');
+}
+
+static bool cmdCurve(char cmd, uint8_t chn)
+{
+    // "Jnc" - Set brightness curve of ch. #n (see Curves::Id)
+    if(!chan[chn].setCurve(msgBuf[2] - '0')) return false;
+    chan[chn].refresh();
+    return true;
+}
+
+static bool cmdCurvePoint(char cmd, uint8_t chn)
+{
+    // "jkxxxyyy" - Set custom curve point #k to (xxx,yyy)
+    bool     ok = true;
+    uint16_t x  = readNum3w(&msgBuf[2], ok);
+    uint16_t y  = readNum3w(&msgBuf[5], ok);
+    if(!ok || x > 255 || y > 255) return false;
+    if(!Curves::setPoint(msgBuf[1] - '0', (uint8_t)x, (uint8_t)y)) return false;
+    refreshAll();
+    return true;
+}
+
+static bool cmdMaxCur(char cmd, uint8_t chn)
+{
+    // "fnccc" - Set max current of ch. #n (0.1 A units)
+    bool     ok = true;
+    uint16_t c  = readNum3w(&msgBuf[2], ok);
+    if(!ok || c > 255) return false;
+    chan[chn].setMaxCur((uint8_t)c);
+    chan[chn].refresh();
+    return true;
+}
+
+static bool cmdBudget(char cmd, uint8_t chn)
+{
+    // "qbbbb" - Set power budget (0.1 A units; 0 = no limit)
+    bool     ok = true;
+    uint16_t b  = readNum3w(&msgBuf[1], ok) * 10;
+    if(msgBuf[4] < '0' || msgBuf[4] > '9') ok = false;
+    b += (uint8_t)(msgBuf[4] - '0');
+    return ok && Budget::setLimit(b);
+}
+
+static bool cmdFlags(char cmd, uint8_t chn)
+{
+    // "nAIRC" - Set all flags for channel #n
+    chan[chn].active        = (msgBuf[1] == 'A');
+    chan[chn].internal      = (msgBuf[2] == 'I');
+    chan[chn].reverse       = (msgBuf[3] == 'R');
+    chan[chn].LEDcorrect    = (msgBuf[4] == 'C');
+    chan[chn].refresh();
+    return true;
+}
+
+static bool cmdSave(char cmd, uint8_t chn)
+{
+    // "s"/"S"- Save current params
+    saveParams();
+    return true;
+}
+
+static bool cmdRevert(char cmd, uint8_t chn)
+{
+    // "x/X"- Discard changes, revert to last saved configuration
+    fetchParams();
+    refreshAll();
+    return true;
+}
+
+static bool cmdFactory(char cmd, uint8_t chn)
+{
+    // "F"- Reset to factory defaults
+    resetParams();
+    refreshAll();
+    return true;
+}
+
+static bool cmdReportVals(char cmd, uint8_t chn)
+{
+    // "p" - Report current channel values
+    // Reports setpoint value; does not report 0 if inactive
+    for(uint8_t i = 0; i < MAX_CH; i++) {
+        Serial.print("Ch");
+        Serial.print(i);
+        Serial.print(" = ");
+        Serial.println(chan[i].PWMval);
+    }           
+    return true;
+}
+
+static void printDeciAmps(uint16_t v)
+{
+    Serial.print(v / 10);
+    Serial.print('.');
+    Serial.print(v % 10);
+}
+
+static bool cmdReportParams(char cmd, uint8_t chn)
+{
+    // "P" - Report current channel parameters
+    Serial.println(F("Active/Internal/Reverse/Corrected+curve/filter Weight/max current"));
+    for(uint8_t i = 0; i < MAX_CH; i++) {
+        Serial.print(i);
+        Serial.print(chan[i].active     ? ": A " : ": - ");
+        Serial.print(chan[i].internal     ? "I " :   "- ");
+        Serial.print(chan[i].reverse      ? "R " :   "- ");
+        Serial.print(chan[i].LEDcorrect   ? "C" :    "-");
+        Serial.print(chan[i].curve);
+        Serial.print(" W");
+        Serial.print(chan[i].weight);
+        Serial.print(" ");
+        printDeciAmps(chan[i].maxCur);
+        Serial.println("A");
+    }           
+    // Budget, total requested load, and scale applied to outputs
+    Serial.print(F("Budget "));
+    printDeciAmps(Budget::limit());
+    Serial.print(F("A, load "));
+    printDeciAmps((Budget::load() + 8) >> 4);
+    Serial.print(F("A, scale "));
+    Serial.print((uint16_t)(((uint32_t)Budget::factor() * 100) >> 15));
+    Serial.println("%");
+    return true;
+}
+
+static bool cmdReportWrites(char cmd, uint8_t chn)
+{
+    // "w" - Report output writes / writes skipped (unchanged value)
+    for(uint8_t i = 0; i < MAX_CH; i++) {
+        Serial.print("Ch");
+        Serial.print(i);
+        Serial.print(": W ");
+        Serial.print(chan[i].writeCnt);
+        Serial.print(" / S ");
+        Serial.println(chan[i].skipCnt);
+    }           
+    Serial.print(F("EE (last save): W "));
+    Serial.print(cfgStore.lastWrites());
+    Serial.print(" / S ");
+    Serial.println(cfgStore.lastSkips());
+    return true;
+}
+
+static bool cmdAckMode(char cmd, uint8_t chn)
+{
+    // "Kn" - Set reply mode for binary frames
+    uint8_t m = msgBuf[1] - '0';
+    if(m > BinCmd::ACK_BATCH) return false;
+    BinCmd::setAckMode(m);
+    return true;
+}
+
+static bool cmdBinStats(char cmd, uint8_t chn)
+{
+    // "k" - Report binary frame counters
+    BinCmd::printStats();
+    return true;
+}
+
+static bool cmdBaud(char cmd, uint8_t chn)
+{
+    // "Un" - Set baud rate (table index), or auto-baud at next boot (n=9).
+    // A new rate is applied at once, after the reply; save to keep it.
+    uint8_t n = msgBuf[1] - '0';
+    if(n == Baud::AUTO) {
+        baudSel = n;
+        return true;
+    }
+    if(n >= Baud::NumRates) return false;
+    baudSel = n;
+    newBaud = n;
+    return true;
+}
+
+static bool cmdReportBaud(char cmd, uint8_t chn)
+{
+    // "u" - Report baud rate
+    Serial.print(F("Baud "));
+    Serial.print(Baud::rate(Baud::current()));
+    Serial.print(F(" / Setting "));
+    Serial.println(baudSel);
+    return true;
+}
+
+static bool cmdDmxAddr(char cmd, uint8_t chn)
+{
+    // "Mnnn" - Set DMX start address (001..DMX_ADDR_MAX)
+    bool     ok = true;
+    uint16_t a  = readNum3w(&msgBuf[1], ok);
+    if(!ok || a < 1 || a > DMX_ADDR_MAX) return false;
+    dmxAddr = a;
+#ifdef USE_DMX
+    Dmx::setAddress(a);
+#endif
+    return true;
+}
+
+static bool cmdDmxStatus(char cmd, uint8_t chn)
+{
+    // "m" - Report DMX address and counters
+    Serial.print(F("DMX addr "));
+    Serial.print(dmxAddr);
+#ifdef USE_DMX
+    Serial.print(F(" / Packets "));
+    Serial.print(Dmx::packets());
+    Serial.print(F(" / Ignored "));
+    Serial.print(Dmx::ignored());
+    Serial.print(F(" / Overruns "));
+    Serial.print(Dmx::overruns());
+#endif
+    Serial.println();
+    return true;
+}
+
+static bool cmdNodeAddr(char cmd, uint8_t chn)
+{
+    // "Nnnn" - Set bus node address (001..254; 000 = standalone)
+    bool     ok = true;
+    uint16_t a  = readNum3w(&msgBuf[1], ok);
+    if(!ok || a > 254) return false;
+    // A standalone node being given an address stays selected, for the
+    // link it is set up from
+    if(nodeAddr == 0) nodeSel = true;
+    nodeAddr = (uint8_t)a;
+    return true;
+}
+
+static bool cmdNodeReport(char cmd, uint8_t chn)
+{
+    // "n" - Report bus node address
+    Serial.print(F("Node "));
+    Serial.println(nodeAddr);
+    return true;
+}
+
+static bool cmdNodeSelect(char cmd, uint8_t chn)
+{
+    // "@nnn" - Select node for the following text commands
+    // (255 = all nodes, no replies)
+    bool     ok = true;
+    uint16_t a  = readNum3w(&msgBuf[1], ok);
+    if(!ok || a > 255) return false;
+    nodeAll = (a == BinCmd::BROADCAST);
+    nodeSel = nodeAll || (a == nodeAddr);
+    return true;
+}
+
+static bool cmdPlay(char cmd, uint8_t chn)
+{
+    // "Dn"/"dn"- Play script #n, continuous/one-shot
+    // (0 = channel sequence, 1 = all channels, 2 = user script)
+    uint8_t n = msgBuf[1] - '0';
+    if(n > Player::USER) return false;
+    Player::start(n, (cmd == 'D'));
+    return true;
+}
+
+static bool cmdStop(char cmd, uint8_t chn)
+{
+    // "E" - Stop script
+    Player::stop();
+    return true;
+}
+
+static bool cmdScriptWrite(char cmd, uint8_t chn)
+{
+    // "Wooohhhhhhhh" - Write 4 bytes (hex) of user script at offset ooo
+    bool     ok = true;
+    uint16_t o  = readNum3w(&msgBuf[1], ok);
+    uint8_t  data[4];
+    for(uint8_t i = 0; i < 4; i++) {
+        int8_t hi = hexDigit(msgBuf[4 + 2*i]);
+        int8_t lo = hexDigit(msgBuf[5 + 2*i]);
+        if(hi < 0 || lo < 0) return false;
+        data[i] = (uint8_t)((hi << 4) | lo);
+    }
+    if(!ok || o > 255) return false;
+    return Player::store((uint8_t)o, data, 4);
+}
+
+static bool cmdHelp(char cmd, uint8_t chn)
+{
+    // "h"/"H"- Print command help
+    printHelp();
+    return true;
+}
+
+// =========================================
+//  TEST/DEBUG COMMANDS
+// =========================================
+
+static bool cmdDumpEE(char cmd, uint8_t chn)
+{
+    // "ynnn" - Print <nnn> bytes from EEPROM (start from current pos)
+    // "Ynnn" - Print <nnn> bytes from EEPROM (start from 0)
+    uint16_t pos = (cmd == 'y' ? cfgStore.getCurrPos() : cfgStore.getBase());
+    printEEpromContent(pos, readNum3(&msgBuf[1]));
+    return true;
+}
+
+static bool cmdEraseEE(char cmd, uint8_t chn)
+{
+    // "Z" - Reset (zero out) EEPROM
+    cfgStore.erase();
+    if(canReply()) printEEpromContent(0, 64);
+    return true;
+}
+
+#ifdef  PROFILE
+static bool cmdBench(char cmd, uint8_t chn)
+{
+    // "Q" - Profile hot path kernels and loop() pass
+    printBench();
+    return true;
+}
+#endif
+
+const CmdDef CmdTable[] PROGMEM = {
+    { 'V', 5, CF_CH,     cmdValue        },
+    { 'v', 5, CF_CH,     cmdValue        },
+    { 'B', 5, CF_CH,     cmdStage        },
+    { 'b', 5, CF_CH,     cmdStage        },
+    { 'L', 1, 0,         cmdLatch        },
+    { 'l', 1, 0,         cmdLatch        },
+    { 'T', 12, 0,        cmdFade         },
+    { 'O', 1, 0,         cmdAllOnOff     },
+    { 'o', 1, 0,         cmdAllOnOff     },
+    { 'A', 2, CF_CH,     cmdActive       },
+    { 'a', 2, CF_CH,     cmdActive       },
+    { 'I', 2, CF_CH,     cmdInternal     },
+    { 'i', 2, CF_CH,     cmdInternal     },
+    { 'R', 2, CF_CH,     cmdReverse      },
+    { 'r', 2, CF_CH,     cmdReverse      },
+    { 'C', 2, CF_CH,     cmdCorrect      },
+    { 'c', 2, CF_CH,     cmdCorrect      },
+    { '0', 5, CF_CH0,    cmdFlags        },
+    { 'G', 3, CF_CH,     cmdWeight       },
+    { 'J', 3, CF_CH,     cmdCurve        },
+    { 'j', 8, 0,         cmdCurvePoint   },
+    { 'f', 5, CF_CH,     cmdMaxCur       },
+    { 'q', 5, 0,         cmdBudget       },
+    { 'S', 1, 0,         cmdSave         },
+    { 's', 1, 0,         cmdSave         },
+    { 'X', 1, 0,         cmdRevert       },
+    { 'x', 1, 0,         cmdRevert       },
+    { 'F', 1, 0,         cmdFactory      },
+    { 'p', 1, CF_REPORT, cmdReportVals   },
+    { 'P', 1, CF_REPORT, cmdReportParams },
+    { 'w', 1, CF_REPORT, cmdReportWrites },
+    { 'K', 2, 0,         cmdAckMode      },
+    { 'k', 1, CF_REPORT, cmdBinStats     },
+    { 'U', 2, 0,         cmdBaud         },
+    { 'u', 1, CF_REPORT, cmdReportBaud   },
+    { 'M', 4, 0,         cmdDmxAddr      },
+    { 'm', 1, CF_REPORT, cmdDmxStatus    },
+    { 'N', 4, 0,         cmdNodeAddr     },
+    { 'n', 1, CF_REPORT, cmdNodeReport   },
+    { '@', 4, CF_ANYNODE,cmdNodeSelect   },
+    { 'D', 2, 0,         cmdPlay         },
+    { 'd', 2, 0,         cmdPlay         },
+    { 'E', 1, 0,         cmdStop         },
+    { 'W', 12, 0,        cmdScriptWrite  },
+    { 'H', 1, CF_NOECHO | CF_REPORT, cmdHelp },
+    { 'h', 1, CF_NOECHO | CF_REPORT, cmdHelp },
+    { '?', 1, CF_NOECHO | CF_REPORT, cmdHelp },
+    { 'Y', 4, CF_REPORT, cmdDumpEE       },
+    { 'y', 4, CF_REPORT, cmdDumpEE       },
+    { 'Z', 1, 0,         cmdEraseEE      },
+#ifdef  PROFILE
+    { 'Q', 1, CF_REPORT, cmdBench        },
+#endif
+};
+const uint8_t CmdCount = sizeof(CmdTable)/sizeof(CmdTable[0]);
+
+static bool findCommand(char c, CmdDef &def)
+{
+    if(c >= '0' && c <= '9') c = '0';
+    for(uint8_t i = 0; i < CmdCount; i++) {
+        if((char)pgm_read_byte(&CmdTable[i].cmd) == c) {
+            memcpy_P(&def, &CmdTable[i], sizeof(CmdDef));
+            return (def.len <= MsgBufLen);
         }
-        break;
+    }
+    return false;
+}
 
-        default: 
-            if(cmd != '\n' && cmd != '\r') {
-                Serial.print(cmd);
-                Serial.println(" ?");
-            } else {
-                resetCmd();
-            }
-        break;
+static void runCommand(void)
+{
+    char    cmd = msgBuf[0];
+    uint8_t chn = 0;
+    bool    ok  = true;
+
+    if(curCmd.flags & CF_CH0) {
+        ok  = isChannelOK(msgBuf[0]);
+        chn = msgBuf[0] - '0';
+    } else 
+    if(curCmd.flags & CF_CH) {
+        ok  = isChannelOK(msgBuf[1]);
+        chn = msgBuf[1] - '0';
+    }
+    uint8_t flags = curCmd.flags;
+    CmdFn   fn    = curCmd.fn;
+    // Reset before running: handlers may feed or flush chars themselves
+    resetCmd();
+    if(nodeAddr != 0 && !nodeSel && !(flags & CF_ANYNODE)) return;
+    // Report only: nothing to do if it can't be sent
+    if((flags & CF_REPORT) && !canReply()) return;
+
+    // Bus driver is enabled before the handler, which may print a report
+    // (selection commands decide afterwards)
+    bool say = !(flags & CF_ANYNODE) && canReply();
+    if(say) Rs485::txEnable();
+    if(ok) ok = fn(cmd, chn);
+    if(flags & CF_ANYNODE) {
+        say = canReply();
+        if(say) Rs485::txEnable();
+    }
 
+    if(say) {
+        if(!(flags & CF_NOECHO)) Serial.print(cmd);
+        Serial.println(ok ? " OK" : " ERR");
     }
-    if(cmdDone || cmdErr) {
-        resetCmd();
-        Serial.print(cmd);
-        Serial.println(cmdErr ? " ERR" : " OK");
+
+    if(newBaud != 0xFF) {
+        Baud::change(newBaud);
+        newBaud = 0xFF;
     }
 }
+
+#endif  //!DMX_ON_UART0
+
+// end serialCmd.cpp
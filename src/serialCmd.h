@@ -16,6 +16,14 @@
 
 void processCmds(unsigned long now);
 
+// Boot state of a bus node: not selected, text commands wait for "@nnn"
+void deselectNode(void);
+
+// Feed a single char to the command parser, as if received from Serial
+void feedCmdChar(char c);
+// Suppress "OK"/"ERR" replies (for profiling)
+void setCmdQuiet(bool quiet);
+
 void printAllValues(void);
 
 #endif  //!__SERIALCMD__H__
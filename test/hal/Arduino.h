@@ -0,0 +1,888 @@
+// =======================================================================
+// @file        Arduino.h
+//
+// @project     NanoPWM
+// @details     Host simulation of the Arduino AVR core (ATmega328P, Nano)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __SIM_ARDUINO__H__
+#define __SIM_ARDUINO__H__
+
+// Stands in for the Arduino core in [env:native*] builds (see
+// platformio.ini), so that src/ and lib/ compile unchanged for the host,
+// AVR register code included.
+//
+// - Registers are plain variables with the ATmega328P names and bit
+//   numbers; the firmware reads and writes them as usual, and tests check
+//   them directly.
+// - ISR(vec) defines a function named after the vector; every vector is
+//   also declared weak here, so a test can fire it (if(vec) vec()) whether
+//   or not the module defining it is built.
+// - Time only moves with sim::advance() (or delay()), in 4us steps (the
+//   resolution of micros()). Each step runs the parts of the chip that
+//   raise interrupts: the Timer0 compare tick, Timer1/Timer2 in the
+//   core's phase-correct PWM mode (overflow at BOTTOM), Timer2 in normal
+//   mode (prescaler 64), the ADC (104us per conversion) and the EEPROM
+//   ready interrupt (3.4ms per byte written). The PWM timers also track
+//   the compare values in use, as the chip's double buffering does. ISRs run with interrupts off, as
+//   on the chip, and only if SREG.I is set.
+// - analogRead() returns scripted values per pin; digitalWrite() and
+//   analogWrite() are recorded, and behave as the core's (analogWrite()
+//   connects timer pins, digitalWrite() disconnects them).
+// - Serial captures output and serves injected input (see HardwareSerial);
+//   EEPROM (EEPROM.h) counts erase/write cycles and can simulate a power
+//   loss; Wire (Wire.h) plays the bus master.
+// sim::reset() brings everything back to the state after the core's
+// init(); module state in src/ is not reset.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <deque>
+
+#ifndef ARDUINO_ARCH_AVR
+#define ARDUINO_ARCH_AVR
+#endif
+#ifndef __AVR_ATmega328P__
+#define __AVR_ATmega328P__
+#endif
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+#ifndef ARDUINO
+#define ARDUINO 10819
+#endif
+// Marks host builds against this HAL
+#define SIM_AVR
+
+// ----------------------------------------------------------------------
+// Types and constants
+// ----------------------------------------------------------------------
+
+typedef uint8_t  byte;
+typedef bool     boolean;
+typedef unsigned int word;
+
+#define HIGH            0x1
+#define LOW             0x0
+#define INPUT           0x0
+#define OUTPUT          0x1
+#define INPUT_PULLUP    0x2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PIN_A0  14
+#define PIN_A1  15
+#define PIN_A2  16
+#define PIN_A3  17
+#define PIN_A4  18
+#define PIN_A5  19
+#define PIN_A6  20
+#define PIN_A7  21
+static const uint8_t A0 = PIN_A0;
+static const uint8_t A1 = PIN_A1;
+static const uint8_t A2 = PIN_A2;
+static const uint8_t A3 = PIN_A3;
+static const uint8_t A4 = PIN_A4;
+static const uint8_t A5 = PIN_A5;
+static const uint8_t A6 = PIN_A6;
+static const uint8_t A7 = PIN_A7;
+#define LED_BUILTIN 13
+#define NUM_DIGITAL_PINS 20
+
+#define NOT_A_PIN       0
+#define NOT_A_PORT      0
+#define PB              2
+#define PC              3
+#define PD              4
+
+#define NOT_ON_TIMER    0
+#define TIMER0A         1
+#define TIMER0B         2
+#define TIMER1A         3
+#define TIMER1B         4
+#define TIMER1C         5
+#define TIMER2          6
+#define TIMER2A         7
+#define TIMER2B         8
+
+#define _BV(bit)        (1 << (bit))
+#define bit(b)          (1UL << (b))
+#define bitRead(v, b)   (((v) >> (b)) & 0x01)
+#define bitSet(v, b)    ((v) |= (1UL << (b)))
+#define bitClear(v, b)  ((v) &= ~(1UL << (b)))
+#define bitWrite(v, b, x) ((x) ? bitSet(v, b) : bitClear(v, b))
+#define lowByte(w)      ((uint8_t)((w) & 0xFF))
+#define highByte(w)     ((uint8_t)((w) >> 8))
+
+#define clockCyclesPerMicrosecond()  (F_CPU / 1000000L)
+
+// ----------------------------------------------------------------------
+// Program memory: plain const data on the host
+// ----------------------------------------------------------------------
+
+#define PROGMEM
+#define PGM_P               const char *
+#define PSTR(s)             (s)
+#define pgm_read_byte(p)    (*(const uint8_t *)(p))
+#define pgm_read_word(p)    (*(const uint16_t *)(p))
+#define pgm_read_dword(p)   (*(const uint32_t *)(p))
+#define pgm_read_byte_near(p)   pgm_read_byte(p)
+#define pgm_read_word_near(p)   pgm_read_word(p)
+#define memcpy_P            memcpy
+#define strlen_P            strlen
+
+class __FlashStringHelper;
+#define F(s)    (reinterpret_cast<const __FlashStringHelper *>(s))
+
+// ----------------------------------------------------------------------
+// Registers (ATmega328P names and bit numbers)
+// ----------------------------------------------------------------------
+
+namespace sim
+{
+    namespace r
+    {
+        inline volatile uint8_t  SREG;
+        inline volatile uint8_t  PORTB, PORTC, PORTD;
+        inline volatile uint8_t  DDRB, DDRC, DDRD;
+        inline volatile uint8_t  PINB, PINC, PIND;
+        inline volatile uint8_t  TCCR0A, TCCR0B, TIMSK0, TIFR0, OCR0A, OCR0B, TCNT0;
+        inline volatile uint8_t  TCCR1A, TCCR1B, TIMSK1, TIFR1;
+        inline volatile uint16_t OCR1A, OCR1B, ICR1, TCNT1;
+        inline volatile uint8_t  TCCR2A, TCCR2B, TIMSK2, TIFR2, OCR2A, OCR2B, TCNT2;
+        inline volatile uint8_t  ADMUX, ADCSRA, ADCSRB;
+        inline volatile uint16_t ADC;
+        inline volatile uint8_t  EECR, EEDR;
+        inline volatile uint16_t EEAR;
+        inline volatile uint8_t  UCSR0A, UCSR0B, UCSR0C, UDR0;
+        inline volatile uint16_t UBRR0;
+    }
+}
+
+#define SREG    (::sim::r::SREG)
+#define PORTB   (::sim::r::PORTB)
+#define PORTC   (::sim::r::PORTC)
+#define PORTD   (::sim::r::PORTD)
+#define DDRB    (::sim::r::DDRB)
+#define DDRC    (::sim::r::DDRC)
+#define DDRD    (::sim::r::DDRD)
+#define PINB    (::sim::r::PINB)
+#define PINC    (::sim::r::PINC)
+#define PIND    (::sim::r::PIND)
+#define TCCR0A  (::sim::r::TCCR0A)
+#define TCCR0B  (::sim::r::TCCR0B)
+#define TIMSK0  (::sim::r::TIMSK0)
+#define TIFR0   (::sim::r::TIFR0)
+#define OCR0A   (::sim::r::OCR0A)
+#define OCR0B   (::sim::r::OCR0B)
+#define TCNT0   (::sim::r::TCNT0)
+#define TCCR1A  (::sim::r::TCCR1A)
+#define TCCR1B  (::sim::r::TCCR1B)
+#define TIMSK1  (::sim::r::TIMSK1)
+#define TIFR1   (::sim::r::TIFR1)
+#define OCR1A   (::sim::r::OCR1A)
+#define OCR1B   (::sim::r::OCR1B)
+#define ICR1    (::sim::r::ICR1)
+#define TCNT1   (::sim::r::TCNT1)
+#define TCCR2A  (::sim::r::TCCR2A)
+#define TCCR2B  (::sim::r::TCCR2B)
+#define TIMSK2  (::sim::r::TIMSK2)
+#define TIFR2   (::sim::r::TIFR2)
+#define OCR2A   (::sim::r::OCR2A)
+#define OCR2B   (::sim::r::OCR2B)
+#define TCNT2   (::sim::r::TCNT2)
+#define ADMUX   (::sim::r::ADMUX)
+#define ADCSRA  (::sim::r::ADCSRA)
+#define ADCSRB  (::sim::r::ADCSRB)
+#define ADC     (::sim::r::ADC)
+#define EECR    (::sim::r::EECR)
+#define EEDR    (::sim::r::EEDR)
+#define EEAR    (::sim::r::EEAR)
+#define UCSR0A  (::sim::r::UCSR0A)
+#define UCSR0B  (::sim::r::UCSR0B)
+#define UCSR0C  (::sim::r::UCSR0C)
+#define UDR0    (::sim::r::UDR0)
+#define UBRR0   (::sim::r::UBRR0)
+
+#define SREG_I  7
+
+#define PD0     0
+
+// Timer0
+#define WGM00   0
+#define WGM01   1
+#define COM0B0  4
+#define COM0B1  5
+#define COM0A0  6
+#define COM0A1  7
+#define CS00    0
+#define CS01    1
+#define CS02    2
+#define TOIE0   0
+#define OCIE0A  1
+#define OCIE0B  2
+
+// Timer1
+#define WGM10   0
+#define WGM11   1
+#define COM1B0  4
+#define COM1B1  5
+#define COM1A0  6
+#define COM1A1  7
+#define CS10    0
+#define CS11    1
+#define CS12    2
+#define WGM12   3
+#define WGM13   4
+#define TOIE1   0
+#define OCIE1A  1
+#define OCIE1B  2
+#define TOV1    0
+#define OCF1A   1
+#define OCF1B   2
+
+// Timer2
+#define WGM20   0
+#define WGM21   1
+#define COM2B0  4
+#define COM2B1  5
+#define COM2A0  6
+#define COM2A1  7
+#define CS20    0
+#define CS21    1
+#define CS22    2
+#define TOIE2   0
+#define OCIE2A  1
+#define OCIE2B  2
+#define TOV2    0
+#define OCF2A   1
+#define OCF2B   2
+
+// ADC
+#define REFS1   7
+#define REFS0   6
+#define ADLAR   5
+#define ADEN    7
+#define ADSC    6
+#define ADATE   5
+#define ADIF    4
+#define ADIE    3
+#define ADPS2   2
+#define ADPS1   1
+#define ADPS0   0
+
+// EEPROM
+#define EERIE   3
+#define EEMPE   2
+#define EEPE    1
+#define EERE    0
+#define E2END   0x3FF
+
+// USART0
+#define RXC0    7
+#define TXC0    6
+#define UDRE0   5
+#define FE0     4
+#define DOR0    3
+#define UPE0    2
+#define U2X0    1
+#define MPCM0   0
+#define RXCIE0  7
+#define TXCIE0  6
+#define UDRIE0  5
+#define RXEN0   4
+#define TXEN0   3
+#define UCSZ01  2
+#define UCSZ00  1
+#define USBS0   3
+
+// ----------------------------------------------------------------------
+// Interrupts
+// ----------------------------------------------------------------------
+
+extern "C" {
+    void ADC_vect(void)             __attribute__((weak));
+    void TIMER0_COMPA_vect(void)    __attribute__((weak));
+    void TIMER1_OVF_vect(void)      __attribute__((weak));
+    void TIMER2_OVF_vect(void)      __attribute__((weak));
+    void TIMER2_COMPA_vect(void)    __attribute__((weak));
+    void USART_RX_vect(void)        __attribute__((weak));
+    void USART1_RX_vect(void)       __attribute__((weak));
+    void EE_READY_vect(void)        __attribute__((weak));
+}
+
+#define ISR(vec, ...)   extern "C" void vec(void)
+
+inline void cli(void)           { SREG &= (uint8_t)~_BV(SREG_I); }
+inline void sei(void)           { SREG |= _BV(SREG_I); }
+inline void noInterrupts(void)  { cli(); }
+inline void interrupts(void)    { sei(); }
+
+// ----------------------------------------------------------------------
+// Pin mapping (Nano)
+// ----------------------------------------------------------------------
+
+inline uint8_t digitalPinToPort(uint8_t pin)
+{
+    if(pin < 8)  return PD;
+    if(pin < 14) return PB;
+    if(pin < 20) return PC;
+    return NOT_A_PORT;
+}
+
+inline uint8_t digitalPinToBitMask(uint8_t pin)
+{
+    if(pin < 8)  return (uint8_t)_BV(pin);
+    if(pin < 14) return (uint8_t)_BV(pin - 8);
+    if(pin < 20) return (uint8_t)_BV(pin - 14);
+    return 0;
+}
+
+inline uint8_t digitalPinToTimer(uint8_t pin)
+{
+    switch(pin) {
+        case 3:  return TIMER2B;
+        case 5:  return TIMER0B;
+        case 6:  return TIMER0A;
+        case 9:  return TIMER1A;
+        case 10: return TIMER1B;
+        case 11: return TIMER2A;
+        default: return NOT_ON_TIMER;
+    }
+}
+
+inline volatile uint8_t *portOutputRegister(uint8_t port)
+{
+    switch(port) {
+        case PB: return &PORTB;
+        case PC: return &PORTC;
+        case PD: return &PORTD;
+        default: return nullptr;
+    }
+}
+
+inline volatile uint8_t *portModeRegister(uint8_t port)
+{
+    switch(port) {
+        case PB: return &DDRB;
+        case PC: return &DDRC;
+        case PD: return &DDRD;
+        default: return nullptr;
+    }
+}
+
+inline volatile uint8_t *portInputRegister(uint8_t port)
+{
+    switch(port) {
+        case PB: return &PINB;
+        case PC: return &PINC;
+        case PD: return &PIND;
+        default: return nullptr;
+    }
+}
+
+// ----------------------------------------------------------------------
+// Simulation state
+// ----------------------------------------------------------------------
+
+namespace sim
+{
+    constexpr uint16_t StepUs     = 4;      // micros() resolution
+    constexpr uint16_t AdcConvUs  = 104;    // 13 ADC clocks @ 125 kHz
+    constexpr uint16_t EeWriteUs  = 3400;   // Erase + write
+    constexpr uint16_t EeSize     = E2END + 1;
+
+    struct PinEvent
+    {
+        uint32_t us;
+        uint8_t  pin;
+        int      val;
+    };
+
+    inline uint32_t now = 0;                // Time in us (wraps as micros())
+
+    inline std::vector<PinEvent> digitalLog;
+    inline std::vector<PinEvent> analogLog;
+
+    // Scripted analog inputs (per ADC channel): each read takes the next
+    // value, the last one then sticks
+    inline std::deque<uint16_t> analogScript[8];
+    inline uint16_t analogLast[8];
+    inline uint32_t analogReads = 0;        // analogRead() calls
+    inline uint32_t adcConversions = 0;     // Conversions started via ADSC
+
+    // Inputs read by digitalRead() (pins with no level set read high:
+    // pull-ups enabled by the firmware)
+    inline uint8_t  pinInput[NUM_DIGITAL_PINS + 2];
+
+    // PWM timer as set up by the core (prescaler 64: one count per step).
+    // In PWM modes OCRnx are double-buffered: the compare values in use
+    // are taken at BOTTOM (fast PWM) or at TOP (phase-correct), once per
+    // period.
+    struct PwmTimer
+    {
+        uint16_t phase   = 0;           // Phase-correct: 0..509, up then down
+        uint16_t ocrA    = 0;           // Compare values in use
+        uint16_t ocrB    = 0;
+        uint32_t periods = 0;           // Times the compare values were taken
+
+        void take(uint16_t a, uint16_t b)
+        {
+            ocrA = a;
+            ocrB = b;
+            periods++;
+        }
+
+        /// One count in 8-bit phase-correct mode; true at BOTTOM
+        bool count(uint16_t a, uint16_t b)
+        {
+            phase = (uint16_t)((phase + 1) % 510);
+            if(phase == 255) take(a, b);
+            return (phase == 0);
+        }
+    };
+    inline PwmTimer pwm0, pwm1, pwm2;
+
+    // ADC conversion in progress
+    inline bool     adcBusy = false;
+    inline uint32_t adcDoneAt = 0;
+
+    // EEPROM array and wear/power-fail simulation (see EEPROM.h)
+    struct Eeprom
+    {
+        uint8_t  mem[EeSize];
+        uint32_t erases[EeSize];        // Erase/write cycles per cell
+        uint32_t totalWrites = 0;       // Cells actually written
+        uint32_t failAfter  = 0;        // Power lost after this many writes (0 = never)
+        bool     powerLost  = false;    // Writes are ignored from then on
+        uint32_t busyUntil  = 0;
+
+        void clear(void)
+        {
+            memset(mem, 0xFF, sizeof(mem));
+            memset(erases, 0, sizeof(erases));
+            totalWrites = 0;
+            failAfter   = 0;
+            powerLost   = false;
+            busyUntil   = 0;
+        }
+
+        void store(uint16_t pos, uint8_t val)
+        {
+            pos &= E2END;
+            if(powerLost) return;
+            if(failAfter && totalWrites + 1 >= failAfter) {
+                // Cut off in the middle of this write: cell left erased
+                mem[pos]  = 0xFF;
+                powerLost = true;
+                return;
+            }
+            mem[pos] = val;
+            erases[pos]++;
+            totalWrites++;
+            busyUntil = now + EeWriteUs;
+        }
+
+        uint32_t maxErases(void) const
+        {
+            uint32_t m = 0;
+            for(uint16_t i = 0; i < EeSize; i++) if(erases[i] > m) m = erases[i];
+            return m;
+        }
+    };
+    inline Eeprom eeprom;
+
+    inline uint8_t adcChannel(uint8_t pin)
+    {
+        return (pin >= 14) ? (uint8_t)(pin - 14) : pin;
+    }
+
+    /// Analog input on <pin> (A0..A7 or 0..7) reads <val> from now on
+    inline void setAnalog(uint8_t pin, uint16_t val)
+    {
+        uint8_t ch = adcChannel(pin) & 7;
+        analogScript[ch].clear();
+        analogLast[ch] = val;
+    }
+
+    /// Queue values to be returned by the next reads of <pin>
+    inline void scriptAnalog(uint8_t pin, const std::vector<uint16_t> &vals)
+    {
+        uint8_t ch = adcChannel(pin) & 7;
+        for(uint16_t v : vals) analogScript[ch].push_back(v);
+    }
+
+    inline uint16_t sampleAnalog(uint8_t ch)
+    {
+        ch &= 7;
+        if(!analogScript[ch].empty()) {
+            analogLast[ch] = analogScript[ch].front();
+            analogScript[ch].pop_front();
+        }
+        return analogLast[ch] & 0x3FF;
+    }
+
+    /// Level read by digitalRead(<pin>)
+    inline void setInput(uint8_t pin, uint8_t level)
+    {
+        if(pin < sizeof(pinInput)) pinInput[pin] = level;
+    }
+
+    /// Run <isr> as the chip would: only with interrupts on, and with
+    /// interrupts off while it runs
+    inline void raise(void (*isr)(void))
+    {
+        if(!isr || !(SREG & _BV(SREG_I))) return;
+        uint8_t s = SREG;
+        SREG = s & (uint8_t)~_BV(SREG_I);
+        isr();
+        SREG = s | _BV(SREG_I);
+    }
+
+    inline void step(void)
+    {
+        uint32_t prev = now;
+        now += StepUs;
+
+        // Timer0 (core setup: fast PWM, prescaler 64): one compare match
+        // per 1024us cycle
+        if((now >> 10) != (prev >> 10)) {
+            pwm0.take(OCR0A, OCR0B);
+            if(TIMSK0 & _BV(OCIE0A)) raise(TIMER0_COMPA_vect);
+        }
+
+        // Timer1/Timer2 (core setup: 8-bit phase-correct PWM, prescaler
+        // 64): one overflow per 2040us cycle
+        if((TCCR1A & 0x03) == _BV(WGM10) && (TCCR1B & 0x1F) == (_BV(CS11) | _BV(CS10))) {
+            if(pwm1.count(OCR1A, OCR1B) && (TIMSK1 & _BV(TOIE1))) raise(TIMER1_OVF_vect);
+        }
+        if((TCCR2A & 0x03) == _BV(WGM20) && (TCCR2B & 0x0F) == _BV(CS22)) {
+            if(pwm2.count(OCR2A, OCR2B) && (TIMSK2 & _BV(TOIE2))) raise(TIMER2_OVF_vect);
+        }
+
+        // Timer2, normal mode with prescaler 64 (as set up by SoftPwm):
+        // one count per step
+        if(TCCR2A == 0 && (TCCR2B & 0x07) == _BV(CS22)) {
+            TCNT2 = (uint8_t)(TCNT2 + 1);
+            if(TCNT2 == 0 && (TIMSK2 & _BV(TOIE2))) raise(TIMER2_OVF_vect);
+            if(TCNT2 == OCR2A) {
+                TIFR2 |= _BV(OCF2A);
+                if(TIMSK2 & _BV(OCIE2A)) {
+                    TIFR2 &= (uint8_t)~_BV(OCF2A);
+                    raise(TIMER2_COMPA_vect);
+                }
+            }
+        }
+
+        // ADC: a conversion starts when ADSC is seen set
+        if((ADCSRA & _BV(ADEN)) && (ADCSRA & _BV(ADSC))) {
+            if(!adcBusy) {
+                adcBusy   = true;
+                adcDoneAt = prev + AdcConvUs;
+                adcConversions++;
+            }
+            if((int32_t)(now - adcDoneAt) >= 0) {
+                adcBusy = false;
+                ADC     = sampleAnalog(ADMUX & 0x07);
+                ADCSRA  = (ADCSRA & (uint8_t)~_BV(ADSC)) | _BV(ADIF);
+                if(ADCSRA & _BV(ADIE)) {
+                    ADCSRA &= (uint8_t)~_BV(ADIF);
+                    raise(ADC_vect);
+                }
+            }
+        }
+
+        // EEPROM ready: level interrupt, whenever no write is in progress
+        if((EECR & _BV(EERIE)) && (int32_t)(now - eeprom.busyUntil) >= 0) {
+            raise(EE_READY_vect);
+        }
+    }
+
+    /// Let <us> microseconds pass
+    inline void advance(uint32_t us)
+    {
+        for(uint32_t t = 0; t < us; t += StepUs) step();
+    }
+
+    void resetSerial(void);
+
+    /// State after the core's init(): timers set up for analogWrite(),
+    /// ADC enabled, interrupts on, time 0, logs cleared; the EEPROM is
+    /// erased unless <keepEeprom> (a power cycle)
+    inline void reset(bool keepEeprom = false)
+    {
+        now = 0;
+        SREG   = _BV(SREG_I);
+        PORTB  = PORTC = PORTD = 0;
+        DDRB   = DDRC  = DDRD  = 0;
+        PINB   = PINC  = PIND  = 0xFF;
+        TCCR0A = _BV(WGM01) | _BV(WGM00);
+        TCCR0B = _BV(CS01) | _BV(CS00);
+        TIMSK0 = _BV(TOIE0);
+        TIFR0  = 0;
+        OCR0A  = OCR0B = TCNT0 = 0;
+        TCCR1A = _BV(WGM10);
+        TCCR1B = _BV(CS11) | _BV(CS10);
+        TIMSK1 = TIFR1 = 0;
+        OCR1A  = OCR1B = ICR1 = TCNT1 = 0;
+        TCCR2A = _BV(WGM20);
+        TCCR2B = _BV(CS22);
+        TIMSK2 = TIFR2 = 0;
+        OCR2A  = OCR2B = TCNT2 = 0;
+        ADMUX  = 0;
+        ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+        ADCSRB = 0;
+        ADC    = 0;
+        EECR   = 0;
+        EEAR   = 0;
+        UCSR0A = UCSR0B = UCSR0C = UDR0 = 0;
+        UBRR0  = 0;
+        digitalLog.clear();
+        analogLog.clear();
+        for(uint8_t i = 0; i < 8; i++) {
+            analogScript[i].clear();
+            analogLast[i] = 0;
+        }
+        analogReads = 0;
+        adcConversions = 0;
+        adcBusy = false;
+        pwm0 = pwm1 = pwm2 = PwmTimer();
+        memset(pinInput, HIGH, sizeof(pinInput));
+        if(keepEeprom) {
+            eeprom.failAfter = 0;
+            eeprom.powerLost = false;
+            eeprom.busyUntil = 0;
+        } else {
+            eeprom.clear();
+        }
+        resetSerial();
+    }
+
+    /// Deliver a byte to the USART0 RX interrupt (DMX, or any code
+    /// taking over the UART); <frameErr> flags a break, <overrun> a lost
+    /// byte before this one
+    inline void uartRx(uint8_t d, bool frameErr = false, bool overrun = false)
+    {
+        UCSR0A = (uint8_t)(_BV(RXC0) | (frameErr ? _BV(FE0) : 0) | (overrun ? _BV(DOR0) : 0));
+        UDR0   = d;
+        raise(USART_RX_vect);
+    }
+}
+
+// ----------------------------------------------------------------------
+// Core functions
+// ----------------------------------------------------------------------
+
+inline unsigned long micros(void)   { return sim::now; }
+inline unsigned long millis(void)   { return sim::now / 1000UL; }
+inline void delay(unsigned long ms) { sim::advance(ms * 1000UL); }
+inline void delayMicroseconds(unsigned int us) { sim::advance(us); }
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+    volatile uint8_t *ddr  = portModeRegister(digitalPinToPort(pin));
+    volatile uint8_t *port = portOutputRegister(digitalPinToPort(pin));
+    uint8_t m = digitalPinToBitMask(pin);
+    if(!ddr) return;
+    if(mode == OUTPUT) {
+        *ddr |= m;
+    } else {
+        *ddr &= (uint8_t)~m;
+        if(mode == INPUT_PULLUP) *port |= m; else *port &= (uint8_t)~m;
+    }
+}
+
+// As the core: a timer pin is disconnected from its timer first
+inline void turnOffPWM(uint8_t timer)
+{
+    switch(timer) {
+        case TIMER0A: TCCR0A &= (uint8_t)~_BV(COM0A1); break;
+        case TIMER0B: TCCR0A &= (uint8_t)~_BV(COM0B1); break;
+        case TIMER1A: TCCR1A &= (uint8_t)~_BV(COM1A1); break;
+        case TIMER1B: TCCR1A &= (uint8_t)~_BV(COM1B1); break;
+        case TIMER2A: TCCR2A &= (uint8_t)~_BV(COM2A1); break;
+        case TIMER2B: TCCR2A &= (uint8_t)~_BV(COM2B1); break;
+        default: break;
+    }
+}
+
+inline void digitalWriteRaw(uint8_t pin, uint8_t val)
+{
+    volatile uint8_t *port = portOutputRegister(digitalPinToPort(pin));
+    if(!port) return;
+    turnOffPWM(digitalPinToTimer(pin));
+    uint8_t m = digitalPinToBitMask(pin);
+    if(val == LOW) *port &= (uint8_t)~m; else *port |= m;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t val)
+{
+    sim::digitalLog.push_back(sim::PinEvent{sim::now, pin, val});
+    digitalWriteRaw(pin, val);
+}
+
+inline int digitalRead(uint8_t pin)
+{
+    return (pin < sizeof(sim::pinInput)) ? sim::pinInput[pin] : LOW;
+}
+
+inline int analogRead(uint8_t pin)
+{
+    sim::analogReads++;
+    return sim::sampleAnalog(sim::adcChannel(pin));
+}
+
+inline void analogWrite(uint8_t pin, int val)
+{
+    sim::analogLog.push_back(sim::PinEvent{sim::now, pin, val});
+    pinMode(pin, OUTPUT);
+    if(val == 0) {
+        digitalWriteRaw(pin, LOW);
+        return;
+    }
+    if(val == 255) {
+        digitalWriteRaw(pin, HIGH);
+        return;
+    }
+    switch(digitalPinToTimer(pin)) {
+        case TIMER0A: TCCR0A |= _BV(COM0A1); OCR0A = (uint8_t)val; break;
+        case TIMER0B: TCCR0A |= _BV(COM0B1); OCR0B = (uint8_t)val; break;
+        case TIMER1A: TCCR1A |= _BV(COM1A1); OCR1A = (uint16_t)val; break;
+        case TIMER1B: TCCR1A |= _BV(COM1B1); OCR1B = (uint16_t)val; break;
+        case TIMER2A: TCCR2A |= _BV(COM2A1); OCR2A = (uint8_t)val; break;
+        case TIMER2B: TCCR2A |= _BV(COM2B1); OCR2B = (uint8_t)val; break;
+        default:      digitalWriteRaw(pin, val < 128 ? LOW : HIGH); break;
+    }
+}
+
+// ----------------------------------------------------------------------
+// Serial
+// ----------------------------------------------------------------------
+
+class Print
+{
+    std::string numStr(unsigned long n, uint8_t base)
+    {
+        char buf[8 * sizeof(long) + 1];
+        char *p = &buf[sizeof(buf) - 1];
+        *p = 0;
+        if(base < 2) base = 10;
+        do {
+            uint8_t d = (uint8_t)(n % base);
+            *--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+            n /= base;
+        } while(n);
+        return p;
+    }
+
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const uint8_t *buf, size_t n)
+    {
+        for(size_t i = 0; i < n; i++) write(buf[i]);
+        return n;
+    }
+    size_t write(const char *s)     { return write((const uint8_t *)s, strlen(s)); }
+
+    size_t print(const char *s)     { return write(s); }
+    size_t print(const __FlashStringHelper *s) { return write(reinterpret_cast<const char *>(s)); }
+    size_t print(const std::string &s) { return write(s.c_str()); }
+    size_t print(char c)            { return write((uint8_t)c); }
+    size_t print(unsigned long n, int base = DEC) { return write(numStr(n, (uint8_t)base).c_str()); }
+    size_t print(long n, int base = DEC)
+    {
+        if(base == DEC && n < 0) return print('-') + print((unsigned long)-n, base);
+        return print((unsigned long)n, base);
+    }
+    size_t print(unsigned char n, int base = DEC)   { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC)             { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC)    { return print((unsigned long)n, base); }
+    size_t print(double d, int digits = 2)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", digits, d);
+        return write(buf);
+    }
+
+    size_t println(void)            { return write("\r\n"); }
+    template<typename T>
+    size_t println(T v)             { size_t n = print(v); return n + println(); }
+    template<typename T>
+    size_t println(T v, int base)   { size_t n = print(v, base); return n + println(); }
+};
+
+class HardwareSerial : public Print
+{
+public:
+    std::deque<uint8_t> rx;         // Input not read yet
+    std::string         tx;         // Output so far
+    unsigned long       baud = 0;   // Rate set by begin(); 0 = closed
+    uint32_t            begins = 0;
+
+    void begin(unsigned long rate)
+    {
+        baud = rate;
+        begins++;
+        UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+    }
+    void end(void)              { baud = 0; UCSR0B = 0; }
+    int  available(void)        { return (int)rx.size(); }
+    int  peek(void)             { return rx.empty() ? -1 : rx.front(); }
+    int  read(void)
+    {
+        if(rx.empty()) return -1;
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    void flush(void)            {}
+    int  availableForWrite(void) { return 63; }
+    operator bool(void)         { return true; }
+
+    // Sent at once: transmit complete is flagged right away
+    using Print::write;
+    size_t write(uint8_t c) override
+    {
+        tx.push_back((char)c);
+        UCSR0A |= _BV(TXC0);
+        return 1;
+    }
+
+    /// Queue input
+    void inject(const char *s)  { while(*s) rx.push_back((uint8_t)*s++); }
+    void inject(const uint8_t *buf, size_t n) { for(size_t i = 0; i < n; i++) rx.push_back(buf[i]); }
+
+    /// Output since last call
+    std::string take(void)
+    {
+        std::string s;
+        s.swap(tx);
+        return s;
+    }
+};
+
+inline HardwareSerial Serial;
+
+inline void sim::resetSerial(void)
+{
+    Serial.rx.clear();
+    Serial.tx.clear();
+    Serial.baud   = 0;
+    Serial.begins = 0;
+}
+
+#endif  //!__SIM_ARDUINO__H__
@@ -0,0 +1,37 @@
+// =======================================================================
+// @file        EEPROM.h
+//
+// @project     NanoPWM
+// @details     Host simulation of the EEPROM library
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __SIM_EEPROM__H__
+#define __SIM_EEPROM__H__
+
+#include <Arduino.h>
+
+// Backed by sim::eeprom (erased by sim::reset()), which also counts
+// erase/write cycles per cell; with sim::eeprom.failAfter = n, the n-th
+// write from then on is cut off (the cell is left erased) and later
+// writes are lost, as after a power failure. A write takes 3.4ms, during
+// which the EEPROM-ready interrupt is held off.
+
+class EEPROMClass
+{
+public:
+    uint8_t read(int idx)               { return sim::eeprom.mem[idx & E2END]; }
+    void    write(int idx, uint8_t val) { sim::eeprom.store((uint16_t)idx, val); }
+    void    update(int idx, uint8_t val)
+    {
+        if(read(idx) != val) write(idx, val);
+    }
+    uint16_t length(void)               { return E2END + 1; }
+};
+
+inline EEPROMClass EEPROM;
+
+#endif  //!__SIM_EEPROM__H__
@@ -0,0 +1,87 @@
+// =======================================================================
+// @file        Wire.h
+//
+// @project     NanoPWM
+// @details     Host simulation of the Wire library (slave side)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __SIM_WIRE__H__
+#define __SIM_WIRE__H__
+
+#include <Arduino.h>
+
+// The firmware is the slave; tests play the master with masterWrite() /
+// masterRead(), which run the receive/request callbacks as the TWI
+// interrupt would (with interrupts off). Buffers are 32 bytes, as in the
+// Wire library: longer writes are truncated, longer reads get 0xFF.
+
+class TwoWire
+{
+public:
+    static constexpr uint8_t BufLen = 32;
+
+    uint8_t  address = 0;           // Slave address set by begin()
+    void   (*recvCb)(int) = nullptr;
+    void   (*reqCb)(void) = nullptr;
+    uint8_t  rxBuf[BufLen];
+    uint8_t  rxLen = 0;
+    uint8_t  rxPos = 0;
+    uint8_t  txBuf[BufLen];
+    uint8_t  txLen = 0;
+
+    void begin(uint8_t addr)            { address = addr; rxLen = rxPos = txLen = 0; }
+    void onReceive(void (*cb)(int))     { recvCb = cb; }
+    void onRequest(void (*cb)(void))    { reqCb = cb; }
+    int  available(void)                { return rxLen - rxPos; }
+    int  read(void)                     { return (rxPos < rxLen) ? rxBuf[rxPos++] : -1; }
+    int  peek(void)                     { return (rxPos < rxLen) ? rxBuf[rxPos] : -1; }
+
+    size_t write(uint8_t b)
+    {
+        if(txLen >= BufLen) return 0;
+        txBuf[txLen++] = b;
+        return 1;
+    }
+    size_t write(const uint8_t *buf, size_t n)
+    {
+        size_t i = 0;
+        while(i < n && write(buf[i])) i++;
+        return i;
+    }
+
+    /// Master writes <n> bytes to this slave
+    void masterWrite(const uint8_t *buf, uint8_t n)
+    {
+        if(n > BufLen) n = BufLen;
+        memcpy(rxBuf, buf, n);
+        rxLen = n;
+        rxPos = 0;
+        if(recvCb) isr([&]{ recvCb(n); });
+    }
+
+    /// Master reads <n> bytes from this slave into <dst>
+    void masterRead(uint8_t *dst, uint8_t n)
+    {
+        txLen = 0;
+        if(reqCb) isr([&]{ reqCb(); });
+        for(uint8_t i = 0; i < n; i++) dst[i] = (i < txLen) ? txBuf[i] : 0xFF;
+    }
+
+private:
+    template<typename F>
+    static void isr(F f)
+    {
+        uint8_t s = SREG;
+        cli();
+        f();
+        SREG = s;
+    }
+};
+
+inline TwoWire Wire;
+
+#endif  //!__SIM_WIRE__H__
@@ -0,0 +1,12 @@
+// =======================================================================
+// @file        avr/io.h
+//
+// @project     NanoPWM
+// @details     Host simulation: all of it is in Arduino.h
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <Arduino.h>
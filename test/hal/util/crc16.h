@@ -0,0 +1,32 @@
+// =======================================================================
+// @file        util/crc16.h
+//
+// @project     NanoPWM
+// @details     Host simulation of avr-libc's CRC helpers (the ones used)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#ifndef __SIM_CRC16__H__
+#define __SIM_CRC16__H__
+
+#include <stdint.h>
+
+// Reference C code from the avr-libc documentation
+static inline uint8_t _crc8_ccitt_update(uint8_t inCrc, uint8_t inData)
+{
+    uint8_t data = inCrc ^ inData;
+    for(uint8_t i = 0; i < 8; i++) {
+        if((data & 0x80) != 0) {
+            data <<= 1;
+            data ^= 0x07;
+        } else {
+            data <<= 1;
+        }
+    }
+    return data;
+}
+
+#endif  //!__SIM_CRC16__H__
@@ -0,0 +1,133 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: interrupt-driven ADC engine (USE_ADC_ISR)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include "main.h"
+#include "AdcEngine.h"
+
+static void boot(void)
+{
+    sim::reset();
+    appSetup();
+    Serial.take();
+}
+
+static void runFor(uint32_t ms)
+{
+    for(uint32_t i = 0; i < ms; i++) {
+        appLoop();
+        sim::advance(1000);
+    }
+}
+
+// Output of the blocking path (analogRead() polled from loop()) once
+// settled on a steady input
+static uint8_t blockingSteady(uint16_t aval)
+{
+    Channel c;
+    uint8_t v = 0;
+    for(uint8_t i = 0; i < 64; i++) v = c.procInVal(aval);
+    return v;
+}
+
+void setUp(void)    { boot(); }
+void tearDown(void) {}
+
+void test_engine_registers(void)
+{
+    // AVcc reference, interrupt on, conversions chained by the ISR
+    TEST_ASSERT_TRUE(ADCSRA & _BV(ADIE));
+    TEST_ASSERT_TRUE(ADCSRA & _BV(ADSC));
+    TEST_ASSERT_EQUAL_HEX8(_BV(REFS0) | 0, ADMUX);
+    sim::advance(sim::AdcConvUs);
+    TEST_ASSERT_EQUAL_HEX8(_BV(REFS0) | 1, ADMUX);
+    TEST_ASSERT_TRUE(ADCSRA & _BV(ADSC));
+}
+
+void test_engine_rotates_channels(void)
+{
+    // The mux follows chan[].ADCpin, one conversion each, then wraps
+    uint32_t c0 = sim::adcConversions;
+    uint8_t  seen[ADC_CH] = {0};
+    for(uint8_t i = 0; i < 2 * ADC_CH; i++) {
+        seen[ADMUX & 0x07]++;
+        sim::advance(sim::AdcConvUs);
+    }
+    for(uint8_t ch = 0; ch < ADC_CH; ch++) TEST_ASSERT_EQUAL_UINT8(2, seen[ch]);
+    TEST_ASSERT_EQUAL_UINT32(c0 + 2 * ADC_CH, sim::adcConversions);
+}
+
+void test_engine_values_and_freshness(void)
+{
+    uint16_t v;
+    for(uint8_t ch = 0; ch < ADC_CH; ch++) sim::setAnalog(A0 + ch, 1000 - 100 * ch);
+    sim::advance(2 * ADC_CH * sim::AdcConvUs);
+    for(uint8_t ch = 0; ch < ADC_CH; ch++) {
+        TEST_ASSERT_TRUE(AdcEngine::get(ch, v));
+        TEST_ASSERT_EQUAL_UINT16(1000 - 100 * ch, v);
+        TEST_ASSERT_EQUAL_UINT16(analogRead(A0 + ch), v);
+        // Same value again, but not fresh
+        TEST_ASSERT_FALSE(AdcEngine::get(ch, v));
+        TEST_ASSERT_EQUAL_UINT16(1000 - 100 * ch, v);
+    }
+}
+
+void test_engine_delivers_every_sample(void)
+{
+    // A reader keeping up gets every conversion of a channel, in order
+    std::vector<uint16_t> ramp;
+    for(uint16_t i = 0; i < 200; i++) ramp.push_back(i * 5);
+    sim::advance(ADC_CH * sim::AdcConvUs);
+    sim::scriptAnalog(A4, ramp);
+    uint16_t v, got = 0;
+    AdcEngine::get(4, v);
+    while(got < ramp.size()) {
+        sim::advance(sim::StepUs);
+        if(AdcEngine::get(4, v)) {
+            TEST_ASSERT_EQUAL_UINT16(ramp[got], v);
+            got++;
+        }
+    }
+}
+
+void test_loop_matches_blocking_path(void)
+{
+    // Same settled outputs as the analogRead() path, without calling it
+    static const uint16_t In[ADC_CH] = { 0, 1, 511, 512, 1022, 1023 };
+    for(uint8_t ch = 0; ch < ADC_CH; ch++) sim::setAnalog(A0 + ch, In[ch]);
+    runFor(500);
+    for(uint8_t ch = 0; ch < ADC_CH; ch++) {
+        TEST_ASSERT_EQUAL_UINT8(blockingSteady(In[ch]), chan[ch].getVal());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, sim::analogReads);
+}
+
+void test_loop_follows_step(void)
+{
+    sim::setAnalog(A1, 0);
+    runFor(300);
+    TEST_ASSERT_EQUAL_UINT8(0, chan[1].getVal());
+    sim::setAnalog(A1, 800);
+    runFor(300);
+    TEST_ASSERT_EQUAL_UINT8(blockingSteady(800), chan[1].getVal());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_engine_registers);
+    RUN_TEST(test_engine_rotates_channels);
+    RUN_TEST(test_engine_values_and_freshness);
+    RUN_TEST(test_engine_delivers_every_sample);
+    RUN_TEST(test_loop_matches_blocking_path);
+    RUN_TEST(test_loop_follows_step);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     On-target benchmarks, run in simavr: exact cycle counts of
+//              the hot path kernels (env:simavr, PROFILE)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include <unity.h>
+#include "main.h"
+#include "serialCmd.h"
+#include "BinCmd.h"
+#include "Fader.h"
+#include "crc8.h"
+#include <ExpFilter.h>
+
+// Timer1 is borrowed as a cycle counter (normal mode, no prescaler), with
+// interrupts off: a kernel call must take less than 65536 cycles.
+// Each kernel is timed Reps times; the cost of reading the counter is
+// taken out.
+constexpr uint8_t Reps = 16;
+
+static volatile uint16_t sink;
+static uint16_t          ovh;
+
+struct T1Regs { uint8_t a, b, msk; uint16_t icr, ocrA, ocrB; };
+static T1Regs t1;
+
+static void t1Borrow(void)
+{
+    t1.a    = TCCR1A;
+    t1.b    = TCCR1B;
+    t1.msk  = TIMSK1;
+    t1.icr  = ICR1;
+    t1.ocrA = OCR1A;
+    t1.ocrB = OCR1B;
+    TIMSK1 = 0;
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+}
+
+static void t1Restore(void)
+{
+    TCCR1B = 0;
+    ICR1   = t1.icr;
+    OCR1A  = t1.ocrA;
+    OCR1B  = t1.ocrB;
+    TCNT1  = 0;
+    TCCR1A = t1.a;
+    TCCR1B = t1.b;
+    TIMSK1 = t1.msk;
+}
+
+template<typename F>
+static uint16_t cycles(F f)
+{
+    uint8_t sreg = SREG;
+    cli();
+    TCNT1 = 0;
+    f();
+    uint16_t c = TCNT1;
+    SREG = sreg;
+    return c;
+}
+
+// Time <f> and print "kernel,reps,avg,max" (cycles per call)
+template<typename F>
+static void bench(const char *name, F f)
+{
+    uint32_t sum = 0;
+    uint16_t max = 0;
+    for(uint8_t i = 0; i < Reps; i++) {
+        uint16_t c = cycles(f);
+        c = (c > ovh) ? c - ovh : 0;
+        sum += c;
+        if(c > max) max = c;
+    }
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%s,%u,%lu,%u", name, Reps, (unsigned long)(sum / Reps), max);
+    TEST_MESSAGE(buf);
+    TEST_ASSERT_TRUE(max > 0);
+}
+
+static Channel                          scratch;
+static ExpFilterQ<2, uint16_t, uint16_t> filterQ(0);
+static Channel::InFilter                inFilter;
+
+void setUp(void)    {}
+void tearDown(void) {}
+
+void test_bench_kernels(void)
+{
+    uint16_t in = 0;
+    uint8_t  v  = 0;
+
+    t1Borrow();
+    ovh = cycles([]{});
+    TEST_MESSAGE("kernel,reps,avg,max");
+
+    bench("procInVal", [&]{ sink = scratch.procInVal(in += 37); });
+    chan[0].internal = false;
+    bench("setVal", [&]{ chan[0].setVal(v += 17); });
+    bench("setValSame", [&]{ chan[0].setVal(v); });
+    bench("ExpFilterQ", [&]{ filterQ.Filter(in += 37); sink = filterQ.Current(); });
+    bench("InFilter", [&]{ sink = inFilter.apply(in += 37); });
+    bench("ease", [&]{ sink = Fader::ease(in += 4099, Fader::IN_OUT); });
+
+    // Full text command, fed one char at a time as from Serial
+    setCmdQuiet(true);
+    bench("cmdFrame", []{
+        feedCmdChar('V'); feedCmdChar('0');
+        feedCmdChar('1'); feedCmdChar('2'); feedCmdChar('8');
+    });
+    setCmdQuiet(false);
+
+    // Binary frame with all channel values, byte by byte
+    uint8_t frm[MAX_CH + 4];
+    frm[0] = BinCmd::SYNC;
+    frm[1] = BinCmd::T_VALUES;
+    frm[2] = MAX_CH;
+    for(uint8_t c = 0; c < MAX_CH; c++) frm[3+c] = 128;
+    frm[MAX_CH+3] = crc8(&frm[1], MAX_CH+2);
+    bench("crc8", [&]{ sink = crc8(&frm[1], MAX_CH+2); });
+    BinCmd::setAckMode(BinCmd::ACK_NONE);
+    bench("binFrame", [&]{
+        for(uint8_t b = 0; b < sizeof(frm); b++) BinCmd::feed(frm[b]);
+    });
+    BinCmd::setAckMode(BinCmd::ACK_EACH);
+
+    t1Restore();
+}
+
+void test_bench_loop_pass(void)
+{
+    // One main loop pass, outputs and inputs idle
+    t1Borrow();
+    appLoop();
+    bench("loopPass", []{ appLoop(); });
+    t1Restore();
+}
+
+void setup()
+{
+    appSetup();
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_kernels);
+    RUN_TEST(test_bench_loop_pass);
+    UNITY_END();
+
+    // simavr quits when the CPU sleeps with interrupts off
+    Serial.flush();
+    cli();
+    sleep_enable();
+    sleep_cpu();
+}
+
+void loop() {}
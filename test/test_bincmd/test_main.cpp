@@ -0,0 +1,207 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: binary framed protocol and CRC-8
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "main.h"
+#include "serialCmd.h"
+#include "BinCmd.h"
+#include "crc8.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static void boot(void)
+{
+    sim::reset();
+    appSetup();
+    Serial.take();
+}
+
+static void runFor(uint32_t ms)
+{
+    for(uint32_t i = 0; i < ms; i++) {
+        appLoop();
+        sim::advance(1000);
+    }
+}
+
+// SYNC TYPE LEN PAYLOAD CRC
+static Bytes frame(uint8_t type, const Bytes &payload)
+{
+    Bytes f = { BinCmd::SYNC, type, (uint8_t)payload.size() };
+    f.insert(f.end(), payload.begin(), payload.end());
+    f.push_back(crc8(&f[1], (uint8_t)(f.size() - 1)));
+    return f;
+}
+
+// Send bytes over the serial line, and return the reply
+static std::string send(const Bytes &b)
+{
+    Serial.inject(b.data(), b.size());
+    runFor(2);
+    return Serial.take();
+}
+
+static const std::string Ack(1, (char)BinCmd::ACK);
+static const std::string Nak(1, (char)BinCmd::NAK);
+
+// Bitwise CRC-8 (poly 0x07), as a reference
+static uint8_t crcRef(uint8_t crc, uint8_t d)
+{
+    crc ^= d;
+    for(uint8_t i = 0; i < 8; i++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    return crc;
+}
+
+void setUp(void)    { boot(); }
+void tearDown(void) {}
+
+void test_crc8_check_value(void)
+{
+    const uint8_t s[] = "123456789";
+    TEST_ASSERT_EQUAL_HEX8(0xF4, crc8(s, 9));
+    for(uint16_t c = 0; c < 256; c++) {
+        for(uint16_t d = 0; d < 256; d++) {
+            if(crc8_update((uint8_t)c, (uint8_t)d) != crcRef((uint8_t)c, (uint8_t)d)) {
+                TEST_FAIL_MESSAGE("crc8_update differs from reference");
+            }
+        }
+    }
+}
+
+void test_frame_values(void)
+{
+    TEST_ASSERT_EQUAL_STRING(Ack.c_str(), send(frame(BinCmd::T_VALUES, { 10, 20, 30 })).c_str());
+    TEST_ASSERT_EQUAL_UINT8(10, chan[0].getVal());
+    TEST_ASSERT_EQUAL_UINT8(20, chan[1].getVal());
+    TEST_ASSERT_EQUAL_UINT8(30, chan[2].getVal());
+    TEST_ASSERT_FALSE(chan[2].internal);
+    TEST_ASSERT_TRUE(chan[3].internal);
+}
+
+void test_frame_bad_crc(void)
+{
+    Bytes f = frame(BinCmd::T_VALUES, { 99 });
+    f.back() ^= 0x01;
+    TEST_ASSERT_EQUAL_STRING(Nak.c_str(), send(f).c_str());
+    TEST_ASSERT_NOT_EQUAL(99, chan[0].getVal());
+}
+
+void test_frame_any_bit_error(void)
+{
+    // Every single-bit error is caught: never acked, never applied
+    Bytes good = frame(BinCmd::T_VALUES, { 1, 2, 3, 4 });
+    for(size_t byte = 1; byte < good.size(); byte++) {
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            Bytes f = good;
+            f[byte] ^= (uint8_t)(1 << bit);
+            std::string r = send(f);
+            BinCmd::reset();
+            TEST_ASSERT_TRUE(r.find((char)BinCmd::ACK) == std::string::npos);
+            TEST_ASSERT_NOT_EQUAL(1, chan[0].getVal());
+        }
+    }
+}
+
+void test_frame_format_errors(void)
+{
+    TEST_ASSERT_EQUAL_STRING(Nak.c_str(), send(frame(BinCmd::T_VALUES, {})).c_str());
+    TEST_ASSERT_EQUAL_STRING(Nak.c_str(), send(frame(BinCmd::T_VALUES, Bytes(MAX_CH + 1, 5))).c_str());
+    TEST_ASSERT_EQUAL_STRING(Nak.c_str(), send(frame(BinCmd::T_LATCH, { 0 })).c_str());
+    TEST_ASSERT_EQUAL_STRING(Nak.c_str(), send(frame(0x7F, { 0 })).c_str());
+    // Mask and value count disagree
+    TEST_ASSERT_EQUAL_STRING(Nak.c_str(), send(frame(BinCmd::T_STAGE, { 0x03, 0x00, 1 })).c_str());
+    // Addressed and slice frames can't be wrapped in an addressed one
+    TEST_ASSERT_EQUAL_STRING(Nak.c_str(), send(frame(BinCmd::T_ADDR, { BinCmd::BROADCAST, BinCmd::T_ADDR })).c_str());
+    TEST_ASSERT_EQUAL_STRING(Nak.c_str(), send(frame(BinCmd::T_ADDR, { BinCmd::BROADCAST, BinCmd::T_SLICE, 1, 1, 9 })).c_str());
+    TEST_ASSERT_NOT_EQUAL(9, chan[0].getVal());
+}
+
+void test_frame_stage_and_latch(void)
+{
+    TEST_ASSERT_EQUAL_STRING(Ack.c_str(), send(frame(BinCmd::T_STAGE, { 0x05, 0x00, 40, 60 })).c_str());
+    TEST_ASSERT_EQUAL_STRING(Ack.c_str(), send(frame(BinCmd::T_STAGE, { 0x02, 0x00, 50 })).c_str());
+    TEST_ASSERT_NOT_EQUAL(40, chan[0].getVal());
+    TEST_ASSERT_EQUAL_STRING(Ack.c_str(), send(frame(BinCmd::T_LATCH, {})).c_str());
+    TEST_ASSERT_EQUAL_UINT8(40, chan[0].getVal());
+    TEST_ASSERT_EQUAL_UINT8(50, chan[1].getVal());
+    TEST_ASSERT_EQUAL_UINT8(60, chan[2].getVal());
+}
+
+void test_frame_interleaved_with_text(void)
+{
+    Bytes b = { 'V', '4' };
+    Bytes f = frame(BinCmd::T_VALUES, { 7 });
+    b.insert(b.end(), f.begin(), f.end());
+    const char *t = "A1";
+    b.insert(b.end(), t, t + 2);
+    // The text frame cut by the binary one is dropped; the next one runs
+    TEST_ASSERT_EQUAL_STRING((Ack + "A OK\r\n").c_str(), send(b).c_str());
+    TEST_ASSERT_EQUAL_UINT8(7, chan[0].getVal());
+}
+
+void test_ack_batch(void)
+{
+    BinCmd::setAckMode(BinCmd::ACK_BATCH);
+    Bytes all;
+    for(uint8_t i = 0; i < 2 * BinCmd::AckBatch; i++) {
+        Bytes f = frame(BinCmd::T_VALUES, { i });
+        all.insert(all.end(), f.begin(), f.end());
+    }
+    TEST_ASSERT_EQUAL_STRING((Ack + Ack).c_str(), send(all).c_str());
+    BinCmd::setAckMode(BinCmd::ACK_EACH);
+}
+
+void test_bench_loopback(void)
+{
+    // Host encoder -> serial line -> parser -> ACK back: frames/s and
+    // payload bytes/s (host time), vs. what the line carries at 1 Mbaud
+    const uint32_t N = 20000;
+    Bytes all;
+    Bytes vals(MAX_CH);
+    for(uint32_t i = 0; i < N; i++) {
+        for(uint8_t c = 0; c < MAX_CH; c++) vals[c] = (uint8_t)(i + c);
+        Bytes f = frame(BinCmd::T_VALUES, vals);
+        all.insert(all.end(), f.begin(), f.end());
+    }
+    Serial.inject(all.data(), all.size());
+    auto t0 = std::chrono::steady_clock::now();
+    processCmds(millis());
+    auto t1 = std::chrono::steady_clock::now();
+    std::string r = Serial.take();
+    TEST_ASSERT_EQUAL_UINT32(N, r.size());
+    TEST_ASSERT_TRUE(r.find((char)BinCmd::NAK) == std::string::npos);
+    // Last frame: ch. #n = N-1+n
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)N, chan[1].getVal());
+
+    double s = std::chrono::duration<double>(t1 - t0).count();
+    char buf[96];
+    snprintf(buf, sizeof(buf), "binFrame,%.0f frames/s,%.0f bytes/s (line at 1M: %.0f frames/s)",
+             N / s, (double)N * MAX_CH / s, 1e6 / 10 / (MAX_CH + 4));
+    TEST_MESSAGE(buf);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc8_check_value);
+    RUN_TEST(test_frame_values);
+    RUN_TEST(test_frame_bad_crc);
+    RUN_TEST(test_frame_any_bit_error);
+    RUN_TEST(test_frame_format_errors);
+    RUN_TEST(test_frame_stage_and_latch);
+    RUN_TEST(test_frame_interleaved_with_text);
+    RUN_TEST(test_ack_batch);
+    RUN_TEST(test_bench_loopback);
+    return UNITY_END();
+}
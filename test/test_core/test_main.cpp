@@ -0,0 +1,401 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: filters, channels, serial parser, config store
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include "main.h"
+#include "serialCmd.h"
+#include "Fader.h"
+#include <ExpFilter.h>
+#include <average_acc.h>
+
+// Boot the firmware on a fresh chip (EEPROM erased: factory defaults),
+// or after a power cycle
+static void boot(bool keepEeprom = false)
+{
+    sim::reset(keepEeprom);
+    appSetup();
+    Serial.take();
+}
+
+// Run the main loop for <ms> of simulated time
+static void runFor(uint32_t ms)
+{
+    for(uint32_t i = 0; i < ms; i++) {
+        appLoop();
+        sim::advance(1000);
+    }
+}
+
+// Send a command, and return the reply
+static std::string command(const char *cmd)
+{
+    Serial.inject(cmd);
+    runFor(2);
+    return Serial.take();
+}
+
+// Host time per call of <f>, in ns (only meaningful relative to other
+// kernels: see test_bench_avr for AVR cycle counts)
+template<typename F>
+static double nsPerCall(uint32_t calls, F f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < calls; i++) f(i);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / calls;
+}
+
+static void report(const char *name, double ns)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s,%.1f ns", name, ns);
+    TEST_MESSAGE(buf);
+}
+
+void setUp(void)    { boot(); }
+void tearDown(void) {}
+
+// ----------------------------------------------------------------------
+// Filters
+// ----------------------------------------------------------------------
+
+void test_expfilterq_settles_at_both_ends(void)
+{
+    ExpFilterQ<2, uint16_t, uint16_t> f(0);
+    for(uint8_t i = 0; i < 64; i++) f.Filter(1023);
+    TEST_ASSERT_EQUAL_UINT16(1023, f.Current());
+    for(uint8_t i = 0; i < 64; i++) f.Filter(0);
+    TEST_ASSERT_EQUAL_UINT16(0, f.Current());
+}
+
+void test_expfilter_int_step(void)
+{
+    // 30% weight: first step from 0 to 100 lands on 30
+    ExpFilter<int> f(30, 0);
+    f.Filter(100);
+    TEST_ASSERT_EQUAL_INT(30, f.Current());
+}
+
+void test_expfilterq_tracks_float(void)
+{
+    // Same response as the float filter with a 1/2^Shift weight, within
+    // rounding, on a noisy 10-bit input
+    ExpFilterQ<2, uint16_t, uint16_t> q2(0);
+    ExpFilterQ<4, uint16_t, uint16_t> q4(0);
+    ExpFilter<float> f2(25.0, 0), f4(6.25, 0);
+    uint32_t seed = 1;
+    for(uint16_t i = 0; i < 5000; i++) {
+        seed = seed * 1103515245UL + 12345;
+        uint16_t in = (i & 0x200) ? 1023 - ((seed >> 16) & 0x3F) : ((seed >> 16) & 0x3F);
+        q2.Filter(in); f2.Filter(in);
+        q4.Filter(in); f4.Filter(in);
+        TEST_ASSERT_FLOAT_WITHIN(1.0, f2.Current(), q2.Current());
+        TEST_ASSERT_FLOAT_WITHIN(1.0, f4.Current(), q4.Current());
+    }
+}
+
+// Every step between two 10-bit values, from a settled state: the output
+// stays between the two, so the accumulator never wrapped
+template<uint8_t Shift>
+static void checkNoOverflow(void)
+{
+    typedef ExpFilterQ<Shift, uint16_t, uint16_t> F;
+    static_assert(F::Fits(1023), "10-bit input must fit");
+    for(uint16_t from = 0; from < 1024; from++) {
+        for(uint16_t to = 0; to < 1024; to++) {
+            F f;
+            f.SetCurrent(from);
+            f.Filter(to);
+            uint16_t v = f.Current();
+            if(v < (from < to ? from : to) || v > (from > to ? from : to)) {
+                TEST_FAIL_MESSAGE("ExpFilterQ output out of range");
+            }
+        }
+    }
+}
+
+void test_expfilterq_no_overflow(void)
+{
+    checkNoOverflow<2>();
+    // Largest shift a 16-bit accumulator takes for 10-bit inputs
+    checkNoOverflow<6>();
+    TEST_ASSERT_FALSE((ExpFilterQ<7, uint16_t, uint16_t>::Fits(1023)));
+    TEST_ASSERT_TRUE((ExpFilterQ<2, uint16_t, int16_t>::Fits(1023)));
+}
+
+void test_average_acc_constant_input(void)
+{
+    AverageAcc a(2);
+    for(uint8_t i = 0; i < 64; i++) a.addVal(500);
+    TEST_ASSERT_TRUE(a.ready());
+    TEST_ASSERT_EQUAL_UINT16(500, a.average());
+}
+
+void test_infilter_rejects_spike(void)
+{
+    Channel::InFilter f;
+    uint16_t v = 0;
+    for(uint8_t i = 0; i < 64; i++) v = f.apply(512);
+    TEST_ASSERT_UINT_WITHIN(2, 512, v);
+    // A single sample off the scale is dropped by the median stage
+    TEST_ASSERT_EQUAL_UINT16(v, f.apply(1023));
+    TEST_ASSERT_EQUAL_UINT16(v, f.apply(512));
+}
+
+void test_infilter_deadband_holds_noise(void)
+{
+    Channel::InFilter f;
+    uint16_t v0 = 0;
+    for(uint8_t i = 0; i < 64; i++) v0 = f.apply(600);
+    // +/-1 LSB of noise does not move the output
+    for(uint8_t i = 0; i < 64; i++) {
+        TEST_ASSERT_EQUAL_UINT16(v0, f.apply((i & 1) ? 601 : 599));
+    }
+}
+
+// ----------------------------------------------------------------------
+// Channels
+// ----------------------------------------------------------------------
+
+void test_channel_cie_output(void)
+{
+    // Ch. #0 is on D3 (OC2B, phase-correct): the compare value is the
+    // CIE table entry
+    chan[0].setVal(128);
+    TEST_ASSERT_EQUAL_UINT8(pgm_read_byte(PWMtables::TAB_CIE_8 + 128), OCR2B);
+    TEST_ASSERT_TRUE(TCCR2A & _BV(COM2B1));
+}
+
+void test_channel_linear_and_reverse(void)
+{
+    chan[0].LEDcorrect = false;
+    chan[0].setVal(100);
+    TEST_ASSERT_EQUAL_UINT8(100, OCR2B);
+    chan[0].reverse = true;
+    chan[0].refresh();
+    TEST_ASSERT_EQUAL_UINT8(155, OCR2B);
+}
+
+void test_channel_inactive_is_off(void)
+{
+    chan[0].LEDcorrect = false;
+    chan[0].setVal(200);
+    chan[0].active = false;
+    chan[0].refresh();
+    TEST_ASSERT_EQUAL_UINT8(0, OCR2B);
+    // Setpoint is kept
+    TEST_ASSERT_EQUAL_UINT8(200, chan[0].getVal());
+}
+
+void test_channel_skips_unchanged_writes(void)
+{
+    uint16_t w = chan[1].writeCnt;
+    uint16_t s = chan[1].skipCnt;
+    chan[1].setVal(50);
+    chan[1].setVal(50);
+    chan[1].setVal(50);
+    TEST_ASSERT_EQUAL_UINT16(w + 1, chan[1].writeCnt);
+    TEST_ASSERT_EQUAL_UINT16(s + 2, chan[1].skipCnt);
+}
+
+void test_channel_pack_roundtrip(void)
+{
+    uint8_t buf[Channel::cfgSize];
+    chan[2].active = true;
+    chan[2].internal = false;
+    chan[2].reverse = true;
+    chan[2].LEDcorrect = false;
+    TEST_ASSERT_EQUAL_UINT8(Channel::cfgSize, chan[2].pack(buf));
+    Channel c;
+    TEST_ASSERT_EQUAL_UINT8(Channel::cfgSize, c.unpack(buf));
+    TEST_ASSERT_TRUE(c.active);
+    TEST_ASSERT_FALSE(c.internal);
+    TEST_ASSERT_TRUE(c.reverse);
+    TEST_ASSERT_FALSE(c.LEDcorrect);
+}
+
+void test_fader_ease_monotonic(void)
+{
+    // Every curve rises from 0 to 1.0 without a step back, over all of p
+    for(uint8_t c = 0; c < Fader::NumCurves; c++) {
+        uint16_t prev = Fader::ease(0, c);
+        TEST_ASSERT_EQUAL_UINT16(0, prev);
+        for(uint32_t p = 1; p <= 0xFFFF; p++) {
+            uint16_t e = Fader::ease((uint16_t)p, c);
+            if(e < prev) {
+                char msg[48];
+                snprintf(msg, sizeof(msg), "curve %u: ease(%lu) < ease(%lu)", c, (unsigned long)p, (unsigned long)p - 1);
+                TEST_FAIL_MESSAGE(msg);
+            }
+            prev = e;
+        }
+        TEST_ASSERT_UINT_WITHIN(2, 0xFFFF, prev);
+    }
+}
+
+void test_pot_drives_output(void)
+{
+    // Channels are polled in turn, one every 2ms
+    sim::setAnalog(A0, 1023);
+    runFor(1000);
+    TEST_ASSERT_EQUAL_UINT8(255, chan[0].getVal());
+    sim::setAnalog(A0, 0);
+    runFor(1000);
+    TEST_ASSERT_EQUAL_UINT8(0, chan[0].getVal());
+}
+
+// ----------------------------------------------------------------------
+// Serial commands
+// ----------------------------------------------------------------------
+
+void test_cmd_set_value(void)
+{
+    TEST_ASSERT_EQUAL_STRING("V OK\r\n", command("V1128").c_str());
+    TEST_ASSERT_EQUAL_UINT8(128, chan[1].getVal());
+    TEST_ASSERT_FALSE(chan[1].internal);
+    // Pot no longer drives the channel
+    sim::setAnalog(A1, 0);
+    runFor(50);
+    TEST_ASSERT_EQUAL_UINT8(128, chan[1].getVal());
+}
+
+void test_cmd_bad_channel(void)
+{
+    TEST_ASSERT_EQUAL_STRING("V ERR\r\n", command("V9128").c_str());
+}
+
+void test_cmd_unknown_char(void)
+{
+    TEST_ASSERT_EQUAL_STRING("% ?\r\n", command("%").c_str());
+}
+
+void test_cmd_split_frame(void)
+{
+    // A frame may arrive over several loop passes
+    TEST_ASSERT_EQUAL_STRING("", command("V2").c_str());
+    TEST_ASSERT_EQUAL_STRING("V OK\r\n", command("077").c_str());
+    TEST_ASSERT_EQUAL_UINT8(77, chan[2].getVal());
+}
+
+void test_cmd_hash_resets_frame(void)
+{
+    TEST_ASSERT_EQUAL_STRING("", command("V2#").c_str());
+    TEST_ASSERT_EQUAL_STRING("a OK\r\n", command("a3").c_str());
+    TEST_ASSERT_FALSE(chan[3].active);
+}
+
+void test_cmd_report_values(void)
+{
+    command("V0010");
+    std::string r = command("p");
+    TEST_ASSERT_TRUE(r.find("Ch0 = 10\r\n") != std::string::npos);
+    TEST_ASSERT_TRUE(r.find("p OK\r\n") != std::string::npos);
+}
+
+// ----------------------------------------------------------------------
+// Config store
+// ----------------------------------------------------------------------
+
+void test_params_survive_power_cycle(void)
+{
+    command("V2100");
+    command("R2");
+    TEST_ASSERT_EQUAL_STRING("S OK\r\n", command("S").c_str());
+    // Quiet time, then one byte per EEPROM-ready interrupt
+    runFor(EEconfig::QuietMs + 1000);
+    TEST_ASSERT_FALSE(cfgStore.pending());
+
+    boot(true);
+    TEST_ASSERT_EQUAL_UINT8(100, chan[2].getVal());
+    TEST_ASSERT_FALSE(chan[2].internal);
+    TEST_ASSERT_TRUE(chan[2].reverse);
+}
+
+void test_unsaved_changes_are_lost(void)
+{
+    command("V2100");
+    runFor(EEconfig::QuietMs + 1000);
+    boot(true);
+    TEST_ASSERT_TRUE(chan[2].internal);
+}
+
+void test_revert_restores_saved(void)
+{
+    command("V3040");
+    command("S");
+    command("V3200");
+    TEST_ASSERT_EQUAL_STRING("X OK\r\n", command("X").c_str());
+    TEST_ASSERT_EQUAL_UINT8(40, chan[3].getVal());
+}
+
+// ----------------------------------------------------------------------
+// Micro-benchmarks (host)
+// ----------------------------------------------------------------------
+
+void test_bench_kernels(void)
+{
+    const uint32_t N = 100000;
+    volatile uint16_t sink = 0;
+    Channel scratch;
+    ExpFilterQ<2, uint16_t, uint16_t> fq(0);
+    ExpFilter<long> fl(30, 0);
+    ExpFilter<float> ff(25.0, 0);
+    Channel::InFilter in;
+
+    report("procInVal", nsPerCall(N, [&](uint32_t i) { sink = scratch.procInVal(i & 0x3FF); }));
+    report("setVal",    nsPerCall(N, [&](uint32_t i) { chan[0].setVal((uint8_t)i); }));
+    report("ExpFilter", nsPerCall(N, [&](uint32_t i) { fl.Filter(i & 0x3FF); sink = fl.Current(); }));
+    report("ExpFilterF", nsPerCall(N, [&](uint32_t i) { ff.Filter(i & 0x3FF); sink = ff.Current(); }));
+    report("ExpFilterQ", nsPerCall(N, [&](uint32_t i) { fq.Filter(i & 0x3FF); sink = fq.Current(); }));
+    report("InFilter",  nsPerCall(N, [&](uint32_t i) { sink = in.apply(i & 0x3FF); }));
+
+    setCmdQuiet(true);
+    double ns = nsPerCall(N, [&](uint32_t) {
+        feedCmdChar('V'); feedCmdChar('0');
+        feedCmdChar('1'); feedCmdChar('2'); feedCmdChar('8');
+    });
+    setCmdQuiet(false);
+    report("cmdFrame", ns);
+    TEST_ASSERT_EQUAL_UINT8(128, chan[0].getVal());
+    (void)sink;
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_expfilterq_settles_at_both_ends);
+    RUN_TEST(test_expfilter_int_step);
+    RUN_TEST(test_expfilterq_tracks_float);
+    RUN_TEST(test_expfilterq_no_overflow);
+    RUN_TEST(test_average_acc_constant_input);
+    RUN_TEST(test_infilter_rejects_spike);
+    RUN_TEST(test_infilter_deadband_holds_noise);
+    RUN_TEST(test_channel_cie_output);
+    RUN_TEST(test_channel_linear_and_reverse);
+    RUN_TEST(test_channel_inactive_is_off);
+    RUN_TEST(test_channel_skips_unchanged_writes);
+    RUN_TEST(test_channel_pack_roundtrip);
+    RUN_TEST(test_fader_ease_monotonic);
+    RUN_TEST(test_pot_drives_output);
+    RUN_TEST(test_cmd_set_value);
+    RUN_TEST(test_cmd_bad_channel);
+    RUN_TEST(test_cmd_unknown_char);
+    RUN_TEST(test_cmd_split_frame);
+    RUN_TEST(test_cmd_hash_resets_frame);
+    RUN_TEST(test_cmd_report_values);
+    RUN_TEST(test_params_survive_power_cycle);
+    RUN_TEST(test_unsaved_changes_are_lost);
+    RUN_TEST(test_revert_restores_saved);
+    RUN_TEST(test_bench_kernels);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: brightness curves and RAM tables (CURVE_TABLES)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <cmath>
+#include "main.h"
+#include "Curves.h"
+
+using namespace Curves;
+
+constexpr uint16_t LutMax = (1U << LutBits) - 1;
+constexpr uint16_t G22    = 563;            // Q8.8
+constexpr uint16_t G28    = 717;
+
+static void boot(void)
+{
+    sim::reset();
+    appSetup();
+    Serial.take();
+}
+
+static bool tableIs(const Lut *t, uint16_t g88)
+{
+    for(uint16_t x = 0; x < 256; x++) {
+        if(t[x] != gamma((uint8_t)x, g88, LutMax)) return false;
+    }
+    return true;
+}
+
+// CIE 1931 luminance for input x (0..255), L* = 100x/255, in 0..1
+static double cieRef(uint8_t x)
+{
+    double l = 100.0 * x / 255;
+    return (l <= 8) ? l / 903.3 : pow((l + 16) / 116, 3);
+}
+
+void setUp(void)    { boot(); }
+void tearDown(void) {}
+
+void test_curves_switch_sole_user(void)
+{
+    // With a single table, a channel can go from one RAM curve to another
+    TEST_ASSERT_EQUAL_INT(1, CURVE_TABLES);
+    TEST_ASSERT_TRUE(chan[0].setCurve(GAMMA22));
+    TEST_ASSERT_TRUE(tableIs(chan[0].lut, G22));
+    TEST_ASSERT_TRUE(chan[0].setCurve(GAMMA28));
+    TEST_ASSERT_EQUAL_UINT8(GAMMA28, chan[0].curve);
+    TEST_ASSERT_TRUE(tableIs(chan[0].lut, G28));
+    // And back to a PROGMEM one, which frees the table
+    TEST_ASSERT_TRUE(chan[0].setCurve(CIE));
+    TEST_ASSERT_NULL(chan[0].lut);
+    TEST_ASSERT_TRUE(chan[1].setCurve(CUSTOM));
+}
+
+void test_curves_shared_table_kept(void)
+{
+    // Table shared with another channel: no switch, and both keep it
+    TEST_ASSERT_TRUE(chan[0].setCurve(GAMMA22));
+    TEST_ASSERT_TRUE(chan[1].setCurve(GAMMA22));
+    TEST_ASSERT_TRUE(chan[0].lut == chan[1].lut);
+    TEST_ASSERT_FALSE(chan[0].setCurve(GAMMA28));
+    TEST_ASSERT_EQUAL_UINT8(GAMMA22, chan[0].curve);
+    TEST_ASSERT_TRUE(chan[0].lut == chan[1].lut);
+    TEST_ASSERT_TRUE(tableIs(chan[0].lut, G22));
+    // Both references are still counted: the table is freed only once
+    // both channels leave it
+    TEST_ASSERT_TRUE(chan[1].setCurve(LINEAR));
+    TEST_ASSERT_FALSE(chan[2].setCurve(GAMMA28));
+    TEST_ASSERT_TRUE(chan[0].setCurve(GAMMA28));
+    TEST_ASSERT_TRUE(tableIs(chan[0].lut, G28));
+}
+
+void test_curves_invalid_kept(void)
+{
+    TEST_ASSERT_TRUE(chan[0].setCurve(GAMMA22));
+    TEST_ASSERT_FALSE(chan[0].setCurve(NumCurves));
+    TEST_ASSERT_EQUAL_UINT8(GAMMA22, chan[0].curve);
+    TEST_ASSERT_TRUE(tableIs(chan[0].lut, G22));
+}
+
+void test_curves_gamma_output(void)
+{
+    // The curve selected drives the output
+    chan[0].internal = false;
+    TEST_ASSERT_TRUE(chan[0].setCurve(GAMMA28));
+    chan[0].setVal(128);
+    // (8-bit outputs in a 12-bit build drop the extra bits)
+    uint8_t drop = LutBits - (chan[0].out.bits() > 8 ? LutBits : 8);
+    TEST_ASSERT_EQUAL_UINT16(gamma(128, G28, LutMax) >> drop, chan[0].outVal);
+}
+
+void test_curves_cie_tables(void)
+{
+    // The PROGMEM tables are filled at compile time by PWMtables::cie():
+    // same values from the generator run here, and within rounding of the
+    // CIE formula evaluated in floating point. Y is scaled by 2^bits and
+    // clamped to full scale; the 8-bit table is rounded from the 12-bit
+    // one, so it may be one more LSB off.
+    uint16_t prev12 = 0;
+    for(uint16_t x = 0; x < 256; x++) {
+        uint16_t t12 = pgm_read_word(PWMtables::TAB_CIE_12 + x);
+        uint8_t  t8  = pgm_read_byte(PWMtables::TAB_CIE_8 + x);
+        TEST_ASSERT_EQUAL_UINT16(PWMtables::cie((uint8_t)x, 12), t12);
+        TEST_ASSERT_EQUAL_UINT16(PWMtables::cie((uint8_t)x, 8), t8);
+        TEST_ASSERT_FLOAT_WITHIN(0.5 + 1e-9, fmin(cieRef((uint8_t)x) * 4096, 4095), t12);
+        TEST_ASSERT_FLOAT_WITHIN(1.0, fmin(cieRef((uint8_t)x) * 256, 255), t8);
+        TEST_ASSERT_TRUE(t12 >= prev12);
+        prev12 = t12;
+    }
+    TEST_ASSERT_EQUAL_UINT16(4095, prev12);
+}
+
+void test_curves_cie_output(void)
+{
+    // A CIE channel takes its output from the table of its resolution
+    chan[0].internal = false;
+    TEST_ASSERT_TRUE(chan[0].setCurve(CIE));
+    TEST_ASSERT_NULL(chan[0].lut);
+    for(uint16_t x = 0; x < 256; x += 15) {
+        chan[0].setVal((uint8_t)x);
+        uint16_t exp = (chan[0].out.bits() > 8) ? pgm_read_word(PWMtables::TAB_CIE_12 + x)
+                                                : pgm_read_byte(PWMtables::TAB_CIE_8 + x);
+        TEST_ASSERT_EQUAL_UINT16(exp, chan[0].outVal);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_curves_switch_sole_user);
+    RUN_TEST(test_curves_shared_table_kept);
+    RUN_TEST(test_curves_invalid_kept);
+    RUN_TEST(test_curves_gamma_output);
+    RUN_TEST(test_curves_cie_tables);
+    RUN_TEST(test_curves_cie_output);
+    return UNITY_END();
+}
@@ -0,0 +1,222 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: DMX512 receiver (USE_DMX), fed byte streams
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <string>
+#include "main.h"
+#include "Dmx.h"
+
+static void boot(void)
+{
+    sim::reset();
+    appSetup();
+}
+
+static void runFor(uint32_t ms)
+{
+    for(uint32_t i = 0; i < ms; i++) {
+        appLoop();
+        sim::advance(1000);
+    }
+}
+
+// Line as seen by the UART, in the form it is recorded by a logic
+// analyzer's async decoder: "BRK" = break (0x00 with framing error),
+// "OVR" = next byte flagged with data overrun, "FE:xx" = framing error
+// on a non-zero byte (noise), anything else = hex byte
+static void play(const std::string &rec)
+{
+    size_t i = 0;
+    bool   ovr = false;
+    while(i < rec.size()) {
+        size_t j = rec.find(' ', i);
+        if(j == std::string::npos) j = rec.size();
+        std::string tok = rec.substr(i, j - i);
+        i = j + 1;
+        if(tok.empty()) continue;
+        if(tok == "BRK") {
+            sim::uartRx(0x00, true);
+        } else if(tok == "OVR") {
+            ovr = true;
+        } else if(tok.compare(0, 3, "FE:") == 0) {
+            sim::uartRx((uint8_t)strtoul(tok.c_str() + 3, nullptr, 16), true);
+        } else {
+            sim::uartRx((uint8_t)strtoul(tok.c_str(), nullptr, 16), false, ovr);
+            ovr = false;
+        }
+        // 44us per char at 250 kbaud, 8N2
+        sim::advance(44);
+    }
+}
+
+// Recording of a packet: break, start code <sc>, then <n> slots where
+// slot k has value <f(k)>
+template<typename F>
+static std::string packet(uint16_t n, F f, uint8_t sc = 0)
+{
+    char b[8];
+    std::string s = "BRK";
+    snprintf(b, sizeof(b), " %02X", sc);
+    s += b;
+    for(uint16_t k = 1; k <= n; k++) {
+        snprintf(b, sizeof(b), " %02X", (uint8_t)f(k));
+        s += b;
+    }
+    return s;
+}
+
+// Counters at the start of the test (they are not reset on boot)
+static uint16_t pkt0, ign0, ovr0;
+static uint16_t packets(void)   { return Dmx::packets() - pkt0; }
+static uint16_t ignored(void)   { return Dmx::ignored() - ign0; }
+static uint16_t overruns(void)  { return Dmx::overruns() - ovr0; }
+
+void setUp(void)
+{
+    boot();
+    pkt0 = Dmx::packets();
+    ign0 = Dmx::ignored();
+    ovr0 = Dmx::overruns();
+}
+void tearDown(void) {}
+
+void test_dmx_uart_setup(void)
+{
+    // 250 kbaud at 16 MHz, 8N2, receive with interrupt only
+    TEST_ASSERT_EQUAL_UINT16(3, UBRR0);
+    TEST_ASSERT_EQUAL_HEX8(_BV(USBS0) | _BV(UCSZ01) | _BV(UCSZ00), UCSR0C);
+    TEST_ASSERT_EQUAL_HEX8(_BV(RXEN0) | _BV(RXCIE0), UCSR0B);
+    TEST_ASSERT_EQUAL_UINT16(1, Dmx::address());
+}
+
+void test_dmx_full_universe(void)
+{
+    play(packet(512, [](uint16_t k) { return k * 3; }));
+    runFor(2);
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) {
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)((ch + 1) * 3), chan[ch].getVal());
+        TEST_ASSERT_FALSE(chan[ch].internal);
+    }
+    TEST_ASSERT_EQUAL_UINT16(1, packets());
+}
+
+void test_dmx_window_at_address(void)
+{
+    Dmx::setAddress(100);
+    play(packet(200, [](uint16_t k) { return k; }));
+    runFor(2);
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) TEST_ASSERT_EQUAL_UINT8(100 + ch, chan[ch].getVal());
+}
+
+void test_dmx_last_address(void)
+{
+    // The window must fit in the universe: the highest address is clamped
+    Dmx::setAddress(512);
+    TEST_ASSERT_EQUAL_UINT16(512 - MAX_CH + 1, Dmx::address());
+    play(packet(512, [](uint16_t k) { return k & 0xFF; }));
+    runFor(2);
+    TEST_ASSERT_EQUAL_UINT8(512 & 0xFF, chan[MAX_CH - 1].getVal());
+}
+
+void test_dmx_short_packet_ignored(void)
+{
+    // A console sending fewer slots than the window: nothing applied
+    Dmx::setAddress(20);
+    play(packet(22, [](uint16_t) { return 0x55; }));
+    play("BRK");
+    runFor(2);
+    TEST_ASSERT_NOT_EQUAL(0x55, chan[0].getVal());
+    TEST_ASSERT_EQUAL_UINT16(0, packets());
+    TEST_ASSERT_EQUAL_UINT16(1, ignored());
+}
+
+void test_dmx_alternate_start_code(void)
+{
+    // RDM / text packets (start code != 0) between dimmer packets
+    play(packet(24, [](uint16_t) { return 10; }));
+    play(packet(24, [](uint16_t) { return 0xEE; }, 0xCC));
+    play(packet(24, [](uint16_t) { return 0xEE; }, 0x17));
+    runFor(2);
+    TEST_ASSERT_EQUAL_UINT8(10, chan[0].getVal());
+    TEST_ASSERT_EQUAL_UINT16(1, packets());
+    TEST_ASSERT_EQUAL_UINT16(2, ignored());
+}
+
+void test_dmx_break_mid_packet(void)
+{
+    // Packet cut by a break before slot 4: dropped, the next one is used
+    play("BRK 00 11 22 33 BRK 00 01 02 03 04 05 06 07 08");
+    runFor(2);
+    TEST_ASSERT_EQUAL_UINT8(1, chan[0].getVal());
+    TEST_ASSERT_EQUAL_UINT8(6, chan[5].getVal());
+    TEST_ASSERT_EQUAL_UINT16(1, ignored());
+}
+
+void test_dmx_noise_and_overrun(void)
+{
+    // Line noise with a framing error on a non-zero byte: resync at the
+    // next break. An overrun is counted.
+    play("BRK 00 40 41 FE:3C 42 43 44 45 46 47 "
+         "BRK 00 50 51 52 OVR 53 54 55 56");
+    runFor(2);
+    TEST_ASSERT_EQUAL_UINT8(0x50, chan[0].getVal());
+    TEST_ASSERT_EQUAL_UINT8(0x55, chan[5].getVal());
+    TEST_ASSERT_EQUAL_UINT16(1, overruns());
+    TEST_ASSERT_EQUAL_UINT16(1, ignored());
+}
+
+void test_dmx_latest_packet_wins(void)
+{
+    // Several packets between loop passes: the last complete one is
+    // applied, as a whole
+    play(packet(MAX_CH, [](uint16_t) { return 1; }));
+    play(packet(MAX_CH, [](uint16_t) { return 2; }));
+    play(packet(MAX_CH, [](uint16_t k) { return 30 + k; }));
+    uint8_t dv[MAX_CH];
+    TEST_ASSERT_TRUE(Dmx::read(dv));
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) TEST_ASSERT_EQUAL_UINT8(31 + ch, dv[ch]);
+    TEST_ASSERT_FALSE(Dmx::read(dv));
+    TEST_ASSERT_EQUAL_UINT16(3, packets());
+}
+
+void test_dmx_recorded_session(void)
+{
+    // Console sending 32 slots, fading ch. 1 up while ch. 2 holds, with
+    // a noise burst (a broken packet) in between
+    std::string rec;
+    for(uint8_t i = 0; i < 20; i++) {
+        rec += packet(32, [i](uint16_t k) { return k == 1 ? i * 10 : (k == 2 ? 0x80 : 0); });
+        rec += " ";
+        if(i == 12) rec += "BRK 00 78 FE:7F 00 00 ";
+    }
+    play(rec);
+    runFor(2);
+    TEST_ASSERT_EQUAL_UINT8(190, chan[0].getVal());
+    TEST_ASSERT_EQUAL_UINT8(0x80, chan[1].getVal());
+    TEST_ASSERT_EQUAL_UINT16(20, packets());
+    TEST_ASSERT_EQUAL_UINT16(1, ignored());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dmx_uart_setup);
+    RUN_TEST(test_dmx_full_universe);
+    RUN_TEST(test_dmx_window_at_address);
+    RUN_TEST(test_dmx_last_address);
+    RUN_TEST(test_dmx_short_packet_ignored);
+    RUN_TEST(test_dmx_alternate_start_code);
+    RUN_TEST(test_dmx_break_mid_packet);
+    RUN_TEST(test_dmx_noise_and_overrun);
+    RUN_TEST(test_dmx_latest_packet_wins);
+    RUN_TEST(test_dmx_recorded_session);
+    return UNITY_END();
+}
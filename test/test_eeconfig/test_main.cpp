@@ -0,0 +1,269 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: config store wear leveling and power failures
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <string.h>
+#include <EEconfig.h>
+
+// Store under test: 10 slots of 24 bytes (20 of payload)
+constexpr uint8_t  Slot   = 24;
+constexpr uint16_t Area   = 240;
+constexpr uint8_t  NSlots = Area / Slot;
+constexpr uint8_t  Len    = Slot - EEconfig::Overhead;
+constexpr uint8_t  Ver    = 3;
+
+// Record #n: every byte depends on n
+static void record(uint16_t n, uint8_t *d)
+{
+    for(uint8_t i = 0; i < Len; i++) d[i] = (uint8_t)(n * 7 + i * 13 + (n >> 8));
+}
+
+// Run the flush to completion, in background: time is skipped to the
+// end of the quiet time, then to the end of each EEPROM write
+static void flush(EEconfig &s)
+{
+    sim::now += EEconfig::QuietMs * 1000UL;
+    s.poll();
+    while(s.pending()) {
+        if((int32_t)(sim::eeprom.busyUntil - sim::now) > 0) sim::now = sim::eeprom.busyUntil;
+        sim::step();
+    }
+}
+
+static void save(EEconfig &s, const uint8_t *d)
+{
+    s.write(d, Len, Ver);
+    flush(s);
+}
+
+// Records of another layout (larger slots and payload, not valid for
+// this one) left over on the chip
+static void leftovers(void)
+{
+    EEconfig old(Slot + 8, Area);
+    uint8_t  od[Len + 8];
+    for(uint16_t n = 0; n < 20; n++) {
+        for(uint8_t i = 0; i < sizeof(od); i++) od[i] = (uint8_t)(n + i);
+        old.write(od, sizeof(od), Ver);
+        flush(old);
+    }
+}
+
+// Power cycle: the chip keeps the EEPROM content only
+static bool remount(uint8_t *d)
+{
+    sim::reset(true);
+    EEconfig s(Slot, Area);
+    memset(d, 0, Len);
+    return s.isValid() && s.version() == Ver && s.read(d, Len) == Len;
+}
+
+void setUp(void)    { sim::reset(); }
+void tearDown(void) {}
+
+void test_ee_wear_leveling(void)
+{
+    // Each cell is erased once per round of the slots, not once per save
+    const uint16_t N = 1000;
+    EEconfig s(Slot, Area);
+    uint8_t  d[Len];
+    for(uint16_t n = 0; n < N; n++) {
+        record(n, d);
+        save(s, d);
+    }
+    uint32_t worst = sim::eeprom.maxErases();
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(N / NSlots + 1, worst);
+    // Outside the area: untouched
+    for(uint16_t i = Area; i < sim::EeSize; i++) TEST_ASSERT_EQUAL_UINT32(0, sim::eeprom.erases[i]);
+
+    char buf[80];
+    snprintf(buf, sizeof(buf), "eeWear,%u saves,%u slots,%lu max erases/cell,%lu cells written",
+             N, NSlots, (unsigned long)worst, (unsigned long)sim::eeprom.totalWrites);
+    TEST_MESSAGE(buf);
+
+    uint8_t r[Len];
+    TEST_ASSERT_TRUE(remount(r));
+    record(N - 1, d);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+}
+
+void test_ee_unchanged_save_writes_nothing(void)
+{
+    EEconfig s(Slot, Area);
+    uint8_t  d[Len];
+    record(1, d);
+    save(s, d);
+    uint32_t w = sim::eeprom.totalWrites;
+    save(s, d);
+    TEST_ASSERT_EQUAL_UINT32(w, sim::eeprom.totalWrites);
+    TEST_ASSERT_EQUAL_UINT16(0, s.lastWrites());
+}
+
+void test_ee_power_fail_at_every_write(void)
+{
+    // A save cut off at any of its writes leaves the previous record
+    // readable; only a completed save (SEQ written last) is seen after it.
+    // Repeated over more saves than slots, for every slot and SEQ wrap.
+    const uint16_t N = 2 * NSlots + 3;
+    uint8_t d[Len], r[Len];
+    uint8_t snap[sim::EeSize];
+
+    {
+        EEconfig s(Slot, Area);
+        record(0, d);
+        save(s, d);
+    }
+    for(uint16_t n = 1; n <= N; n++) {
+        memcpy(snap, sim::eeprom.mem, sizeof(snap));
+        // Writes this save takes, on a dry run
+        uint32_t w0 = sim::eeprom.totalWrites;
+        {
+            sim::reset(true);
+            EEconfig s(Slot, Area);
+            record(n, d);
+            save(s, d);
+        }
+        uint32_t writes = sim::eeprom.totalWrites - w0;
+        TEST_ASSERT_TRUE(writes >= 1);
+
+        for(uint32_t k = 1; k <= writes; k++) {
+            memcpy(sim::eeprom.mem, snap, sizeof(snap));
+            sim::reset(true);
+            EEconfig s(Slot, Area);
+            sim::eeprom.failAfter = sim::eeprom.totalWrites + k;
+            record(n, d);
+            save(s, d);
+            TEST_ASSERT_TRUE(sim::eeprom.powerLost);
+
+            TEST_ASSERT_TRUE(remount(r));
+            record(n - 1, d);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+        }
+
+        // Then the save goes through, for the next round
+        memcpy(sim::eeprom.mem, snap, sizeof(snap));
+        sim::reset(true);
+        EEconfig s(Slot, Area);
+        record(n, d);
+        save(s, d);
+        TEST_ASSERT_TRUE(remount(r));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+    }
+}
+
+void test_ee_power_fail_on_first_record(void)
+{
+    // Chip with records of another layout left over: the first save of
+    // the new layout clears their SEQs; cut off at any write, no record
+    // is found, never a stale one
+    uint8_t d[Len], r[Len];
+    leftovers();
+    uint8_t snap[sim::EeSize];
+    memcpy(snap, sim::eeprom.mem, sizeof(snap));
+
+    for(uint32_t k = 1; ; k++) {
+        memcpy(sim::eeprom.mem, snap, sizeof(snap));
+        sim::reset(true);
+        EEconfig s(Slot, Area);
+        TEST_ASSERT_FALSE(s.isValid());
+        sim::eeprom.failAfter = sim::eeprom.totalWrites + k;
+        record(7, d);
+        save(s, d);
+        bool cut = sim::eeprom.powerLost;
+        bool got = remount(r);
+        if(!cut) {
+            TEST_ASSERT_TRUE(got);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+            break;
+        }
+        if(got) TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+        TEST_ASSERT_TRUE(k < 2000);
+    }
+}
+
+void test_ee_first_save_in_background(void)
+{
+    // The stale SEQs are cleared by the write-behind: starting the flush
+    // writes nothing, and only SEQs are cleared, not whole slots
+    leftovers();
+    sim::reset(true);
+    EEconfig s(Slot, Area);
+    uint8_t  d[Len], r[Len];
+    record(5, d);
+    s.write(d, Len, Ver);
+    sim::now += EEconfig::QuietMs * 1000UL;
+    uint32_t w = sim::eeprom.totalWrites;
+    s.poll();
+    TEST_ASSERT_TRUE(s.pending());
+    TEST_ASSERT_EQUAL_UINT32(w, sim::eeprom.totalWrites);
+    flush(s);
+    TEST_ASSERT_EQUAL_UINT32(s.lastWrites(), sim::eeprom.totalWrites - w);
+    TEST_ASSERT_TRUE(s.lastWrites() < Slot + NSlots);
+    for(uint8_t n = 1; n < NSlots; n++) TEST_ASSERT_EQUAL_HEX8(0xFF, sim::eeprom.mem[n * Slot]);
+    TEST_ASSERT_TRUE(remount(r));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+}
+
+void test_ee_sync(void)
+{
+    // sync() completes the flush by itself, with no EEPROM interrupt
+    // served: from the staged record, and from a flush under way
+    EEconfig s(Slot, Area);
+    uint8_t  d[Len], r[Len];
+    record(1, d);
+    s.write(d, Len, Ver);
+    s.sync();
+    TEST_ASSERT_FALSE(s.pending());
+    TEST_ASSERT_TRUE(remount(r));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+
+    EEconfig s2(Slot, Area);
+    record(2, d);
+    s2.write(d, Len, Ver);
+    sim::now += EEconfig::QuietMs * 1000UL;
+    s2.poll();
+    sim::now = sim::eeprom.busyUntil;
+    sim::step();
+    TEST_ASSERT_TRUE(s2.pending());
+    s2.sync();
+    TEST_ASSERT_FALSE(s2.pending());
+    TEST_ASSERT_TRUE(remount(r));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+}
+
+void test_ee_seq_wraps(void)
+{
+    // SEQ runs 0..254: the latest record is found across wraps, from any
+    // slot
+    EEconfig s(Slot, Area);
+    uint8_t  d[Len], r[Len];
+    for(uint16_t n = 0; n < 700; n++) {
+        record(n, d);
+        save(s, d);
+        if(n % 37 == 0 || (n > 250 && n < 260)) {
+            TEST_ASSERT_TRUE(remount(r));
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(d, r, Len);
+        }
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ee_wear_leveling);
+    RUN_TEST(test_ee_unchanged_save_writes_nothing);
+    RUN_TEST(test_ee_power_fail_at_every_write);
+    RUN_TEST(test_ee_power_fail_on_first_record);
+    RUN_TEST(test_ee_first_save_in_background);
+    RUN_TEST(test_ee_sync);
+    RUN_TEST(test_ee_seq_wraps);
+    return UNITY_END();
+}
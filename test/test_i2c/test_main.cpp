@@ -0,0 +1,244 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: I2C slave register map (USE_I2C)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <vector>
+#include "main.h"
+#include "I2cRegs.h"
+#include <Wire.h>
+
+using namespace I2cRegs;
+
+typedef std::vector<uint8_t> Bytes;
+
+static void boot(void)
+{
+    sim::reset();
+    appSetup();
+    Serial.take();
+}
+
+static void runFor(uint32_t ms)
+{
+    for(uint32_t i = 0; i < ms; i++) {
+        appLoop();
+        sim::advance(1000);
+    }
+}
+
+// Master write transaction: register, then data
+static void writeRegs(uint8_t reg, const Bytes &data)
+{
+    Bytes b = { reg };
+    b.insert(b.end(), data.begin(), data.end());
+    Wire.masterWrite(b.data(), (uint8_t)b.size());
+}
+
+// Master register select, then read transaction of <n> bytes
+static Bytes readRegs(uint8_t reg, uint8_t n)
+{
+    Bytes b(n);
+    Wire.masterWrite(&reg, 1);
+    Wire.masterRead(b.data(), n);
+    return b;
+}
+
+void setUp(void)    { boot(); }
+void tearDown(void) {}
+
+void test_i2c_slave_address(void)
+{
+    TEST_ASSERT_EQUAL_UINT8(0x01, Wire.address);           // I2C_ADDRESS
+    TEST_ASSERT_EQUAL_UINT8(MAX_CH, readRegs(R_NCH, 1)[0]);
+    TEST_ASSERT_EQUAL_UINT8(MapVersion, readRegs(R_VERSION, 1)[0]);
+}
+
+void test_i2c_setpoint_burst(void)
+{
+    // All setpoints in one transaction: applied by the main loop, all
+    // together
+    writeRegs(R_VALUE, { 10, 20, 30, 40, 50, 60 });
+    TEST_ASSERT_TRUE(pending());
+    TEST_ASSERT_NOT_EQUAL(10, chan[0].getVal());
+    runFor(1);
+    TEST_ASSERT_FALSE(pending());
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) {
+        TEST_ASSERT_EQUAL_UINT8(10 * (ch + 1), chan[ch].getVal());
+        TEST_ASSERT_FALSE(chan[ch].internal);
+    }
+}
+
+void test_i2c_read_burst(void)
+{
+    writeRegs(R_VALUE + 2, { 77, 88 });
+    runFor(1);
+    Bytes r = readRegs(R_VALUE, 32);
+    TEST_ASSERT_EQUAL_UINT8(77, r[2]);
+    TEST_ASSERT_EQUAL_UINT8(88, r[3]);
+    // Unmapped registers read as 0xFF
+    for(uint8_t i = MAX_CH; i < R_FLAGS; i++) TEST_ASSERT_EQUAL_HEX8(0xFF, r[i]);
+    // Flags follow in the same burst
+    TEST_ASSERT_EQUAL_HEX8(0x0B, r[R_FLAGS + 0]);
+}
+
+void test_i2c_burst_across_blocks(void)
+{
+    // Pointer auto-increments from the last setpoints into the flags:
+    // unmapped registers in between are skipped
+    Bytes d(R_FLAGS + 2 - (MAX_CH - 1), 0xFF);
+    d[0] = 99;                              // Last setpoint
+    d[d.size() - 2] = 0x05;                 // Ch. #0: active, reverse
+    d[d.size() - 1] = 0x00;                 // Ch. #1: off
+    writeRegs(MAX_CH - 1, d);
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT8(99, chan[MAX_CH - 1].getVal());
+    TEST_ASSERT_TRUE(chan[0].active);
+    TEST_ASSERT_FALSE(chan[0].internal);
+    TEST_ASSERT_TRUE(chan[0].reverse);
+    TEST_ASSERT_FALSE(chan[0].LEDcorrect);
+    TEST_ASSERT_FALSE(chan[1].active);
+}
+
+void test_i2c_burst_truncated_at_buffer(void)
+{
+    // The Wire buffer holds 32 bytes: register + 31 data bytes
+    Bytes d(40, 0x01);
+    writeRegs(R_VALUE, d);
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT8(1, chan[0].getVal());
+    // Reg. 0x10 + 14 = 0x1E is the last one written; the flags of all
+    // channels got b0 only
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) {
+        TEST_ASSERT_TRUE(chan[ch].active);
+        TEST_ASSERT_FALSE(chan[ch].internal);
+    }
+}
+
+void test_i2c_status_and_counters(void)
+{
+    uint16_t w = chan[2].writeCnt;
+    writeRegs(R_VALUE + 2, { 200 });
+    runFor(1);
+    Bytes st = readRegs(R_STATUS + 2, 1);
+    TEST_ASSERT_EQUAL_HEX8(0x01, st[0]);
+    Bytes c = readRegs(R_WRITES + 4, 2);
+    TEST_ASSERT_EQUAL_UINT16(w + 1, c[0] | (c[1] << 8));
+    TEST_ASSERT_EQUAL_UINT16(chan[2].writeCnt, c[0] | (c[1] << 8));
+}
+
+void test_i2c_counter_read_bytewise(void)
+{
+    // LSB and MSB read in separate transactions, with the counter rolling
+    // over from 0x01FF to 0x0200 in between: the MSB is the latched one
+    chan[2].writeCnt = 0x01FF;
+    uint8_t lsb = readRegs(R_WRITES + 4, 1)[0];
+    chan[2].writeCnt = 0x0200;
+    uint8_t msb = readRegs(R_WRITES + 5, 1)[0];
+    TEST_ASSERT_EQUAL_HEX16(0x01FF, lsb | (msb << 8));
+    // MSB alone (no LSB read before it): current value
+    TEST_ASSERT_EQUAL_HEX8(0x02, readRegs(R_WRITES + 5, 1)[0]);
+    // Another counter's LSB read in between does not mix them up
+    chan[3].skipCnt = 0x0304;
+    lsb = readRegs(R_WRITES + 4, 1)[0];
+    readRegs(R_SKIPS + 6, 1);
+    chan[2].writeCnt = 0x0100;
+    msb = readRegs(R_WRITES + 5, 1)[0];
+    TEST_ASSERT_EQUAL_HEX8(0x01, msb);
+    TEST_ASSERT_EQUAL_HEX8(0x03, readRegs(R_SKIPS + 7, 1)[0]);
+}
+
+void test_i2c_read_only_ignored(void)
+{
+    writeRegs(R_NCH, { 42, 42 });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT8(MAX_CH, readRegs(R_NCH, 1)[0]);
+    TEST_ASSERT_EQUAL_UINT8(MapVersion, readRegs(R_VERSION, 1)[0]);
+}
+
+void test_i2c_dmx_address(void)
+{
+    writeRegs(R_DMXADDR, { 0x2C, 0x01 });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT16(300, dmxAddr);
+    Bytes r = readRegs(R_DMXADDR, 2);
+    TEST_ASSERT_EQUAL_UINT8(0x2C, r[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x01, r[1]);
+}
+
+void test_i2c_dmx_address_range(void)
+{
+    // Out of range (as for "M"): ignored, whole
+    writeRegs(R_DMXADDR, { 0x2C, 0x01 });
+    runFor(1);
+    writeRegs(R_DMXADDR, { 0x00, 0x00 });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT16(300, dmxAddr);
+    writeRegs(R_DMXADDR, { (uint8_t)(DMX_ADDR_MAX + 1), (uint8_t)((DMX_ADDR_MAX + 1) >> 8) });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT16(300, dmxAddr);
+    // Only the MSB written: checked on the resulting address
+    writeRegs(R_DMXADDR + 1, { 0x02 });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT16(300, dmxAddr);
+    writeRegs(R_DMXADDR, { (uint8_t)DMX_ADDR_MAX, (uint8_t)(DMX_ADDR_MAX >> 8) });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT16(DMX_ADDR_MAX, dmxAddr);
+}
+
+void test_i2c_command_save_revert(void)
+{
+    writeRegs(R_VALUE + 3, { 33 });
+    runFor(1);
+    writeRegs(R_CMD, { 1 });
+    runFor(1);
+    writeRegs(R_VALUE + 3, { 66 });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT8(66, chan[3].getVal());
+    writeRegs(R_CMD, { 2 });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT8(33, chan[3].getVal());
+    TEST_ASSERT_EQUAL_UINT8(0, readRegs(R_CMD, 1)[0]);
+}
+
+void test_i2c_write_while_pending_counted(void)
+{
+    // A second write before the main loop applied the first one is
+    // dropped (it was acked already): the master can see it in R_DROPS
+    uint8_t d0 = readRegs(R_DROPS, 1)[0];
+    writeRegs(R_VALUE + 1, { 11 });
+    writeRegs(R_VALUE + 1, { 22 });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT8(11, chan[1].getVal());
+    TEST_ASSERT_EQUAL_UINT8(d0 + 1, readRegs(R_DROPS, 1)[0]);
+    // Once applied, writes are taken again
+    writeRegs(R_VALUE + 1, { 33 });
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT8(33, chan[1].getVal());
+    TEST_ASSERT_EQUAL_UINT8(d0 + 1, readRegs(R_DROPS, 1)[0]);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_i2c_slave_address);
+    RUN_TEST(test_i2c_setpoint_burst);
+    RUN_TEST(test_i2c_read_burst);
+    RUN_TEST(test_i2c_burst_across_blocks);
+    RUN_TEST(test_i2c_burst_truncated_at_buffer);
+    RUN_TEST(test_i2c_status_and_counters);
+    RUN_TEST(test_i2c_counter_read_bytewise);
+    RUN_TEST(test_i2c_read_only_ignored);
+    RUN_TEST(test_i2c_dmx_address);
+    RUN_TEST(test_i2c_dmx_address_range);
+    RUN_TEST(test_i2c_command_save_revert);
+    RUN_TEST(test_i2c_write_while_pending_counted);
+    return UNITY_END();
+}
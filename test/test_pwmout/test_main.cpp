@@ -0,0 +1,222 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: direct timer-register PWM output
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include "main.h"
+#include "PwmOut.h"
+#include "SysTick.h"
+
+void setUp(void)    { sim::reset(); }
+void tearDown(void) {}
+
+#if PWM_BITS == 8
+
+// Nano PWM pins, and the compare unit behind each one
+struct PinDesc {
+    uint8_t pin;
+    volatile uint8_t *tccr;
+    uint8_t com1;               // COMnx1: connected
+    uint8_t com0;               // COMnx0: inverting
+    bool    fast;               // Timer0: fast PWM, others phase-correct
+};
+
+static const PinDesc Pins[] = {
+    {  3, &TCCR2A, _BV(COM2B1), _BV(COM2B0), false },
+    {  5, &TCCR0A, _BV(COM0B1), _BV(COM0B0), true  },
+    {  6, &TCCR0A, _BV(COM0A1), _BV(COM0A0), true  },
+    {  9, &TCCR1A, _BV(COM1A1), _BV(COM1A0), false },
+    { 10, &TCCR1A, _BV(COM1B1), _BV(COM1B0), false },
+    { 11, &TCCR2A, _BV(COM2A1), _BV(COM2A0), false },
+};
+
+static uint16_t ocrOf(uint8_t pin)
+{
+    switch(pin) {
+        case  3: return OCR2B;
+        case  5: return OCR0B;
+        case  6: return OCR0A;
+        case  9: return OCR1A;
+        case 10: return OCR1B;
+        default: return OCR2A;
+    }
+}
+
+// Time the pin is high over one PWM period, in half timer counts (a
+// phase-correct period is 510 of them, a fast PWM one 512)
+static uint16_t highTime(const PinDesc &d)
+{
+    uint16_t ocr = ocrOf(d.pin);
+    if(!(*d.tccr & d.com1)) {
+        // Disconnected: the port bit drives the pin
+        uint8_t m = digitalPinToBitMask(d.pin);
+        bool hi = *portOutputRegister(digitalPinToPort(d.pin)) & m;
+        return hi ? (d.fast ? 512 : 510) : 0;
+    }
+    bool inv = (*d.tccr & d.com0);
+    if(d.fast) {
+        uint16_t h = 2 * (ocr + 1);
+        return inv ? 512 - h : h;
+    }
+    uint16_t h = 2 * ocr;
+    return inv ? 510 - h : h;
+}
+
+void test_pwmout_connects_at_zero(void)
+{
+    for(const PinDesc &d : Pins) {
+        PwmOut o;
+        o.begin(d.pin);
+        TEST_ASSERT_TRUE(o.isDirect());
+        TEST_ASSERT_EQUAL_UINT8(8, o.bits());
+        TEST_ASSERT_TRUE(*d.tccr & d.com1);
+        TEST_ASSERT_EQUAL_UINT16(0, highTime(d));
+        TEST_ASSERT_TRUE(*portModeRegister(digitalPinToPort(d.pin)) & digitalPinToBitMask(d.pin));
+    }
+}
+
+void test_pwmout_matches_analogwrite(void)
+{
+    // Same duty as analogWrite() for every value, on every pin
+    for(const PinDesc &d : Pins) {
+        PwmOut o;
+        o.begin(d.pin);
+        for(uint16_t v = 0; v < 256; v++) {
+            o.write(v);
+            uint16_t direct = highTime(d);
+            uint8_t  tccr   = *d.tccr;
+            analogWrite(d.pin, v);
+            TEST_ASSERT_EQUAL_UINT16(highTime(d), direct);
+            // Put the direct output back as it was
+            *d.tccr = tccr;
+        }
+    }
+}
+
+void test_pwmout_never_disconnects(void)
+{
+    // Going through 0% and 100% keeps the pin on the timer (no glitch on
+    // reconnection), and does not go through digitalWrite()/analogWrite()
+    static const uint8_t Seq[] = { 0, 255, 128, 0, 1, 254, 255, 0, 0, 42 };
+    for(const PinDesc &d : Pins) {
+        PwmOut o;
+        o.begin(d.pin);
+        size_t dl = sim::digitalLog.size();
+        size_t al = sim::analogLog.size();
+        for(uint8_t v : Seq) {
+            o.write(v);
+            TEST_ASSERT_TRUE(*d.tccr & d.com1);
+        }
+        TEST_ASSERT_EQUAL_UINT32(dl, sim::digitalLog.size());
+        TEST_ASSERT_EQUAL_UINT32(al, sim::analogLog.size());
+    }
+}
+
+void test_pwmout_fast_pwm_zero_is_inverted_full(void)
+{
+    // Timer0: OCR=0 still gives a spike, so 0% is inverting mode + TOP
+    PwmOut o;
+    o.begin(6);
+    o.write(0);
+    TEST_ASSERT_TRUE(TCCR0A & _BV(COM0A0));
+    TEST_ASSERT_EQUAL_UINT8(255, OCR0A);
+    o.write(10);
+    TEST_ASSERT_FALSE(TCCR0A & _BV(COM0A0));
+    TEST_ASSERT_EQUAL_UINT8(10, OCR0A);
+}
+
+void test_pwmout_no_timer_falls_back(void)
+{
+    // D4 has no timer: plain digital writes
+    PwmOut o;
+    o.begin(4);
+    TEST_ASSERT_FALSE(o.isDirect());
+    o.write(255);
+    TEST_ASSERT_EQUAL_INT(HIGH, sim::digitalLog.back().val);
+    o.write(0);
+    TEST_ASSERT_EQUAL_INT(LOW, sim::digitalLog.back().val);
+}
+
+#else
+
+void test_pwmout_hires_timer1(void)
+{
+    // Timer1 pins: phase-correct, TOP=ICR1, no prescaler, 12 bit
+    PwmOut a, b;
+    a.begin(9, 12);
+    b.begin(10, 8);             // Follows the other Timer1 pin
+    TEST_ASSERT_EQUAL_UINT8(12, a.bits());
+    TEST_ASSERT_EQUAL_UINT8(12, b.bits());
+    TEST_ASSERT_EQUAL_UINT16(4095, ICR1);
+    TEST_ASSERT_EQUAL_HEX8(_BV(WGM13) | _BV(CS10), TCCR1B);
+    TEST_ASSERT_TRUE(TCCR1A & _BV(WGM11));
+    TEST_ASSERT_FALSE(TCCR1A & _BV(WGM10));
+    for(uint16_t v = 0; v < 4096; v += 7) {
+        a.write(v);
+        TEST_ASSERT_EQUAL_UINT16(v, OCR1A);
+    }
+    b.write(4095);
+    TEST_ASSERT_EQUAL_UINT16(4095, OCR1B);
+}
+
+// Sum of the compare values timer <t> took (channel B) over the next <n>
+// PWM periods
+static uint32_t takenSum(const sim::PwmTimer &t, uint8_t n)
+{
+    uint32_t sum = 0;
+    uint32_t end = t.periods + n;
+    while(t.periods != end) {
+        uint32_t p = t.periods;
+        sim::step();
+        if(t.periods != p) sum += t.ocrB;
+    }
+    return sum;
+}
+
+void test_pwmout_dither_average(void)
+{
+    // Other pins: 8-bit compare value, and the low 4 bits spread over 16
+    // PWM periods. What the timer takes (at TOP for phase-correct Timer2,
+    // every 2040us; at BOTTOM for fast PWM Timer0, every 1024us) adds up
+    // to the 12-bit value over any 16 periods. Dither runs from the
+    // timer interrupts, over the channels' outputs.
+    chan[0].out.begin(3, 12);   // OC2B
+    chan[1].out.begin(5, 12);   // OC0B
+    SysTick::begin();
+    TEST_ASSERT_EQUAL_UINT8(12, chan[0].out.bits());
+    TEST_ASSERT_EQUAL_UINT8(12, chan[1].out.bits());
+    for(uint16_t v = 5; v < 4080; v += 29) {
+        chan[0].out.write(v);
+        chan[1].out.write(v);
+        takenSum(sim::pwm2, 2);     // Value in use before the write
+        TEST_ASSERT_EQUAL_UINT32(v, takenSum(sim::pwm2, 16));
+        TEST_ASSERT_EQUAL_UINT32(v, takenSum(sim::pwm2, 16));
+        takenSum(sim::pwm0, 2);
+        TEST_ASSERT_EQUAL_UINT32(v, takenSum(sim::pwm0, 16));
+    }
+}
+
+#endif
+
+int main(void)
+{
+    UNITY_BEGIN();
+#if PWM_BITS == 8
+    RUN_TEST(test_pwmout_connects_at_zero);
+    RUN_TEST(test_pwmout_matches_analogwrite);
+    RUN_TEST(test_pwmout_never_disconnects);
+    RUN_TEST(test_pwmout_fast_pwm_zero_is_inverted_full);
+    RUN_TEST(test_pwmout_no_timer_falls_back);
+#else
+    RUN_TEST(test_pwmout_hires_timer1);
+    RUN_TEST(test_pwmout_dither_average);
+#endif
+    return UNITY_END();
+}
@@ -0,0 +1,231 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: several nodes on one RS-485 bus (USE_RS485)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "main.h"
+#include "serialCmd.h"
+#include "BinCmd.h"
+#include "crc8.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+// Nodes on the bus. The firmware has one set of globals, so each node is
+// booted in turn and fed the same line traffic; what it did is recorded.
+static const uint8_t Nodes[] = { 1, 2, 3, 7 };
+
+struct NodeRun
+{
+    uint8_t     addr;
+    uint8_t     val[MAX_CH];    // Setpoints at the end
+    int32_t     latchAt;        // Byte after which setpoints changed; -1 = never
+    int32_t     changes;        // Bytes after which setpoints changed
+    std::string tx;             // Sent on the bus
+    bool        deLeftOn;       // Driver still enabled when idle
+    bool        deWhileQuiet;   // Driver enabled without sending
+};
+
+static bool deOn(void)
+{
+    return *portOutputRegister(digitalPinToPort(RS485_DE_PIN)) & digitalPinToBitMask(RS485_DE_PIN);
+}
+
+static void snapshot(uint8_t *v)
+{
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) v[ch] = chan[ch].getVal();
+}
+
+// Boot node <addr>, then feed it <line> one byte per main loop pass, as
+// the bus would at low rates
+static NodeRun runNode(uint8_t addr, const Bytes &line)
+{
+    NodeRun r = { addr, {}, -1, 0, "", false, false };
+    sim::reset();
+    appSetup();
+    nodeAddr = addr;
+    // Start from a known state, not following the inputs
+    for(uint8_t ch = 0; ch < MAX_CH; ch++) {
+        chan[ch].internal = false;
+        chan[ch].setVal(0);
+    }
+    Serial.take();
+
+    uint8_t prev[MAX_CH];
+    snapshot(prev);
+    for(size_t i = 0; i < line.size(); i++) {
+        Serial.inject(&line[i], 1);
+        processCmds(millis());
+        // Driver on only while there is a reply going out
+        if(deOn() && Serial.tx.empty()) r.deWhileQuiet = true;
+        r.tx += Serial.take();
+        appLoop();
+        sim::advance(1000);
+
+        uint8_t now[MAX_CH];
+        snapshot(now);
+        if(memcmp(now, prev, MAX_CH) != 0) {
+            if(r.latchAt < 0) r.latchAt = (int32_t)i;
+            r.changes++;
+            memcpy(prev, now, MAX_CH);
+        }
+    }
+    r.tx += Serial.take();
+    r.deLeftOn = deOn();
+    snapshot(r.val);
+    return r;
+}
+
+static std::vector<NodeRun> runBus(const Bytes &line)
+{
+    std::vector<NodeRun> runs;
+    for(uint8_t n : Nodes) runs.push_back(runNode(n, line));
+    return runs;
+}
+
+// SYNC TYPE LEN PAYLOAD CRC
+static Bytes frame(uint8_t type, const Bytes &payload)
+{
+    Bytes f = { BinCmd::SYNC, type, (uint8_t)payload.size() };
+    f.insert(f.end(), payload.begin(), payload.end());
+    f.push_back(crc8(&f[1], (uint8_t)(f.size() - 1)));
+    return f;
+}
+
+static Bytes text(const char *s)
+{
+    return Bytes(s, s + strlen(s));
+}
+
+void setUp(void)    {}
+void tearDown(void) {}
+
+void test_bus_text_before_select(void)
+{
+    // Nodes just booted, no "@nnn" on the line yet: none runs text
+    // commands, none talks
+    Bytes line = text("V1077pn");
+    for(const NodeRun &r : runBus(line)) {
+        TEST_ASSERT_EQUAL_STRING("", r.tx.c_str());
+        TEST_ASSERT_EQUAL_INT32(-1, r.latchAt);
+        TEST_ASSERT_FALSE(r.deWhileQuiet);
+        TEST_ASSERT_FALSE(r.deLeftOn);
+    }
+}
+
+void test_bus_slice_latched_together(void)
+{
+    // One slice frame for nodes 1..3, K = MAX_CH values each: every node
+    // takes its own values, and all apply them on the last (CRC) byte
+    const uint8_t K = MAX_CH;
+    Bytes p = { 1, K };
+    for(uint8_t n = 0; n < 3; n++) {
+        for(uint8_t ch = 0; ch < K; ch++) p.push_back((uint8_t)(10 * (n + 1) + ch));
+    }
+    Bytes line = frame(BinCmd::T_SLICE, p);
+    for(const NodeRun &r : runBus(line)) {
+        TEST_ASSERT_EQUAL_STRING("", r.tx.c_str());
+        TEST_ASSERT_FALSE(r.deLeftOn);
+        TEST_ASSERT_FALSE(r.deWhileQuiet);
+        if(r.addr > 3) {
+            // Beyond the frame: untouched
+            TEST_ASSERT_EQUAL_INT32(-1, r.latchAt);
+            continue;
+        }
+        TEST_ASSERT_EQUAL_INT32((int32_t)line.size() - 1, r.latchAt);
+        TEST_ASSERT_EQUAL_INT32(1, r.changes);
+        for(uint8_t ch = 0; ch < K; ch++) {
+            TEST_ASSERT_EQUAL_UINT8(10 * r.addr + ch, r.val[ch]);
+        }
+    }
+}
+
+void test_bus_broadcast_frame(void)
+{
+    // Broadcast values: run by all, acked by none
+    Bytes line = frame(BinCmd::T_ADDR, { BinCmd::BROADCAST, BinCmd::T_VALUES, 5, 6, 7 });
+    for(const NodeRun &r : runBus(line)) {
+        TEST_ASSERT_EQUAL_STRING("", r.tx.c_str());
+        TEST_ASSERT_FALSE(r.deWhileQuiet);
+        TEST_ASSERT_EQUAL_INT32((int32_t)line.size() - 1, r.latchAt);
+        TEST_ASSERT_EQUAL_UINT8(5, r.val[0]);
+        TEST_ASSERT_EQUAL_UINT8(7, r.val[2]);
+    }
+}
+
+void test_bus_staged_then_broadcast_latch(void)
+{
+    // Values staged node by node, then one broadcast latch: nothing moves
+    // before the latch frame, then all nodes at once
+    Bytes line;
+    for(uint8_t n : Nodes) {
+        Bytes f = frame(BinCmd::T_ADDR, { n, BinCmd::T_STAGE, 0x03, 0x00, n, (uint8_t)(n + 100) });
+        line.insert(line.end(), f.begin(), f.end());
+    }
+    Bytes l = frame(BinCmd::T_ADDR, { BinCmd::BROADCAST, BinCmd::T_LATCH });
+    line.insert(line.end(), l.begin(), l.end());
+    for(const NodeRun &r : runBus(line)) {
+        // Each node acks its own stage frame only
+        TEST_ASSERT_EQUAL_STRING(std::string(1, (char)BinCmd::ACK).c_str(), r.tx.c_str());
+        TEST_ASSERT_FALSE(r.deLeftOn);
+        TEST_ASSERT_EQUAL_INT32((int32_t)line.size() - 1, r.latchAt);
+        TEST_ASSERT_EQUAL_UINT8(r.addr, r.val[0]);
+        TEST_ASSERT_EQUAL_UINT8(r.addr + 100, r.val[1]);
+    }
+}
+
+void test_bus_addressed_frame(void)
+{
+    // Only the addressed node runs it, and it alone talks
+    Bytes line = frame(BinCmd::T_ADDR, { 2, BinCmd::T_VALUES, 42 });
+    for(const NodeRun &r : runBus(line)) {
+        if(r.addr == 2) {
+            TEST_ASSERT_EQUAL_STRING(std::string(1, (char)BinCmd::ACK).c_str(), r.tx.c_str());
+            TEST_ASSERT_EQUAL_UINT8(42, r.val[0]);
+        } else {
+            TEST_ASSERT_EQUAL_STRING("", r.tx.c_str());
+            TEST_ASSERT_EQUAL_INT32(-1, r.latchAt);
+        }
+        TEST_ASSERT_FALSE(r.deWhileQuiet);
+        TEST_ASSERT_FALSE(r.deLeftOn);
+    }
+}
+
+void test_bus_text_broadcast(void)
+{
+    // Text commands to all nodes: run everywhere, silently, reports too
+    Bytes line = text("@255V1077pn@003n");
+    for(const NodeRun &r : runBus(line)) {
+        TEST_ASSERT_EQUAL_UINT8(77, r.val[1]);
+        TEST_ASSERT_EQUAL_INT32(1, r.changes);
+        TEST_ASSERT_FALSE(r.deWhileQuiet);
+        TEST_ASSERT_FALSE(r.deLeftOn);
+        if(r.addr == 3) {
+            TEST_ASSERT_EQUAL_STRING("@ OK\r\nNode 3\r\nn OK\r\n", r.tx.c_str());
+        } else {
+            TEST_ASSERT_EQUAL_STRING("", r.tx.c_str());
+        }
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bus_text_before_select);
+    RUN_TEST(test_bus_slice_latched_together);
+    RUN_TEST(test_bus_broadcast_frame);
+    RUN_TEST(test_bus_staged_then_broadcast_latch);
+    RUN_TEST(test_bus_addressed_frame);
+    RUN_TEST(test_bus_text_broadcast);
+    // Again, with a node left selected by the test above: boot clears it
+    RUN_TEST(test_bus_text_before_select);
+    return UNITY_END();
+}
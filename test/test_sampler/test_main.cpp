@@ -0,0 +1,199 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: SPSC ring and fixed-rate sampler (USE_SAMPLER)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include "main.h"
+#include "Sampler.h"
+#include "SysTick.h"
+#include <RingBuf.h>
+
+// Sampling period of each channel at the default rate
+static const uint32_t PeriodUs = (uint32_t)SMP_RATE * SysTick::TICK_US;
+
+static void boot(void)
+{
+    sim::reset();
+    appSetup();
+    Serial.take();
+    // Drop what was sampled during the boot delays
+    Sample s;
+    while(Sampler::pop(s)) {}
+}
+
+void setUp(void)    { boot(); }
+void tearDown(void) {}
+
+// ----------------------------------------------------------------------
+// RingBuf
+// ----------------------------------------------------------------------
+
+void test_ring_fifo_and_capacity(void)
+{
+    RingBuf<uint8_t, 8> r;
+    uint8_t v;
+    for(uint8_t i = 0; i < 7; i++) TEST_ASSERT_TRUE(r.push(i));
+    TEST_ASSERT_FALSE(r.push(7));       // One slot kept empty
+    TEST_ASSERT_EQUAL_UINT8(1, r.dropped());
+    TEST_ASSERT_EQUAL_UINT8(7, r.count());
+    for(uint8_t i = 0; i < 7; i++) {
+        TEST_ASSERT_TRUE(r.pop(v));
+        TEST_ASSERT_EQUAL_UINT8(i, v);
+    }
+    TEST_ASSERT_FALSE(r.pop(v));
+    TEST_ASSERT_TRUE(r.isEmpty());
+}
+
+void test_ring_wraps_around(void)
+{
+    RingBuf<uint16_t, 4> r;
+    uint16_t v;
+    for(uint16_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(r.push(i));
+        TEST_ASSERT_TRUE(r.push(i + 5000));
+        TEST_ASSERT_TRUE(r.pop(v));
+        TEST_ASSERT_EQUAL_UINT16(i, v);
+        TEST_ASSERT_TRUE(r.pop(v));
+        TEST_ASSERT_EQUAL_UINT16(i + 5000, v);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, r.dropped());
+}
+
+void test_ring_producer_interleaved(void)
+{
+    // Producer (ISR) bursts at arbitrary points between consumer calls:
+    // items come out in order, and each one is either delivered or
+    // counted as dropped
+    RingBuf<uint16_t, 8> r;
+    uint16_t next = 0, delivered = 0, drops = 0, v;
+    int32_t  last = -1;
+    uint32_t seed = 12345;
+    for(uint16_t i = 0; i < 5000; i++) {
+        seed = seed * 1103515245UL + 12345;
+        uint8_t burst = (uint8_t)((seed >> 16) % 4);
+        for(uint8_t b = 0; b < burst; b++) {
+            if(!r.push(next)) drops++;
+            next++;
+        }
+        if(r.pop(v)) {
+            TEST_ASSERT_GREATER_THAN(last, v);
+            last = v;
+            delivered++;
+        }
+    }
+    while(r.pop(v)) delivered++;
+    TEST_ASSERT_EQUAL_UINT16(next, delivered + drops);
+    TEST_ASSERT_EQUAL_UINT8(drops > 255 ? 255 : drops, r.dropped());
+}
+
+// ----------------------------------------------------------------------
+// Sampler
+// ----------------------------------------------------------------------
+
+void test_sampler_fixed_rate(void)
+{
+    // The main loop never runs: the sampler alone keeps the pace. Each
+    // channel gets a new sample every SMP_RATE ticks.
+    uint16_t n[ADC_CH] = {0};
+    uint8_t  drops = Sampler::overruns();
+    Sample   s;
+    for(uint16_t ms = 0; ms < 1000; ms++) {
+        sim::advance(1000);
+        while(Sampler::pop(s)) {
+            TEST_ASSERT_LESS_THAN(ADC_CH, s.ch);
+            n[s.ch]++;
+        }
+    }
+    for(uint8_t ch = 0; ch < ADC_CH; ch++) {
+        TEST_ASSERT_UINT_WITHIN(1, 1000000UL / PeriodUs, n[ch]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(drops, Sampler::overruns());
+}
+
+void test_sampler_sweep_order(void)
+{
+    // Channels come in order, one sweep per period, with the value read
+    // on each one's own pin
+    for(uint8_t ch = 0; ch < ADC_CH; ch++) sim::setAnalog(A0 + ch, 100 * (ch + 1));
+    sim::advance(4 * PeriodUs);
+    // Skip to the end of a sweep
+    Sample s;
+    do {
+        TEST_ASSERT_TRUE(Sampler::pop(s));
+    } while(s.ch != ADC_CH - 1);
+    sim::advance(PeriodUs);
+    for(uint8_t ch = 0; ch < ADC_CH; ch++) {
+        TEST_ASSERT_TRUE(Sampler::pop(s));
+        TEST_ASSERT_EQUAL_UINT8(ch, s.ch);
+        TEST_ASSERT_EQUAL_UINT16(100 * (ch + 1), s.val);
+    }
+}
+
+void test_sampler_latency(void)
+{
+    // A step on the input is seen by the consumer within one sampling
+    // period plus a sweep (ADC_CH conversions)
+    sim::setAnalog(A2, 0);
+    sim::advance(3 * PeriodUs + 500);
+    Sample s;
+    while(Sampler::pop(s)) {}
+
+    uint32_t t0 = micros();
+    sim::setAnalog(A2, 1000);
+    uint32_t lat = 0;
+    while(!lat && micros() - t0 < 10 * PeriodUs) {
+        sim::advance(sim::StepUs);
+        while(Sampler::pop(s)) {
+            if(s.ch == 2 && s.val == 1000) lat = micros() - t0;
+        }
+    }
+    TEST_ASSERT_NOT_EQUAL(0, lat);
+    TEST_ASSERT_LESS_OR_EQUAL(PeriodUs + ADC_CH * sim::AdcConvUs, lat);
+}
+
+void test_sampler_unaffected_by_loop_stalls(void)
+{
+    // Loop passes of up to 8ms: the ring (31 samples, 5 sweeps) absorbs
+    // them, and no tick is late
+    uint8_t drops = Sampler::overruns();
+    uint8_t late  = Sampler::late();
+    sim::setAnalog(A0, 1023);
+    for(uint16_t i = 0; i < 100; i++) {
+        appLoop();
+        sim::advance((i % 10 == 0) ? 8000 : 1000);
+    }
+    TEST_ASSERT_EQUAL_UINT8(drops, Sampler::overruns());
+    TEST_ASSERT_EQUAL_UINT8(late, Sampler::late());
+    TEST_ASSERT_EQUAL_UINT8(255, chan[0].getVal());
+}
+
+void test_sampler_counts_overruns(void)
+{
+    // A stall longer than the ring can hold loses samples, and says so
+    uint8_t drops = Sampler::overruns();
+    appLoop();
+    sim::advance(30000);
+    appLoop();
+    TEST_ASSERT_GREATER_THAN(drops, Sampler::overruns());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_fifo_and_capacity);
+    RUN_TEST(test_ring_wraps_around);
+    RUN_TEST(test_ring_producer_interleaved);
+    RUN_TEST(test_sampler_fixed_rate);
+    RUN_TEST(test_sampler_sweep_order);
+    RUN_TEST(test_sampler_latency);
+    RUN_TEST(test_sampler_unaffected_by_loop_stalls);
+    RUN_TEST(test_sampler_counts_overruns);
+    return UNITY_END();
+}
@@ -0,0 +1,218 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: table-driven serial command parser
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include "main.h"
+#include "serialCmd.h"
+#include "Latch.h"
+
+static void boot(void)
+{
+    sim::reset();
+    appSetup();
+    Serial.take();
+}
+
+static void runFor(uint32_t ms)
+{
+    for(uint32_t i = 0; i < ms; i++) {
+        appLoop();
+        sim::advance(1000);
+    }
+}
+
+static std::string command(const std::string &cmd)
+{
+    Serial.inject(cmd.c_str());
+    runFor(2);
+    return Serial.take();
+}
+
+static bool endsWith(const std::string &s, const char *tail)
+{
+    size_t n = strlen(tail);
+    return s.size() >= n && s.compare(s.size() - n, n, tail) == 0;
+}
+
+void setUp(void)    { boot(); }
+void tearDown(void) {}
+
+// One frame per command in the table, with the reply expected and a
+// check of its effect (if any)
+struct Case
+{
+    const char *frame;
+    const char *reply;          // Tail of the reply
+    bool      (*effect)(void);
+};
+
+static const Case Cases[] = {
+    { "V1128",        "V OK\r\n",  []{ return chan[1].getVal() == 128 && !chan[1].internal; } },
+    { "v2064",        "v OK\r\n",  []{ return chan[2].getVal() == 64; } },
+    { "V6128",        "V ERR\r\n", nullptr },
+    { "B3050",        "B OK\r\n",  []{ return chan[3].getVal() != 50; } },
+    { "L",            "L OK\r\n",  []{ return chan[3].getVal() == 50; } },
+    { "l",            "l OK\r\n",  nullptr },
+    { "T00110000000", "T OK\r\n",  nullptr },
+    { "T00010000000", "T ERR\r\n", nullptr },
+    { "Txyz10000000", "T ERR\r\n", nullptr },
+    { "o",            "o OK\r\n",  []{ return !chan[0].active && !chan[5].active; } },
+    { "O",            "O OK\r\n",  []{ return chan[0].active && chan[5].active; } },
+    { "a4",           "a OK\r\n",  []{ return !chan[4].active; } },
+    { "A4",           "A OK\r\n",  []{ return chan[4].active; } },
+    { "A7",           "A ERR\r\n", nullptr },
+    { "i4",           "i OK\r\n",  []{ return !chan[4].internal; } },
+    { "I4",           "I OK\r\n",  []{ return chan[4].internal; } },
+    { "R4",           "R OK\r\n",  []{ return chan[4].reverse; } },
+    { "r4",           "r OK\r\n",  []{ return !chan[4].reverse; } },
+    { "c4",           "c OK\r\n",  []{ return !chan[4].LEDcorrect; } },
+    { "C4",           "C OK\r\n",  []{ return chan[4].LEDcorrect; } },
+    { "2a-R-",        "2 OK\r\n",  []{ return !chan[2].active && !chan[2].internal && chan[2].reverse && !chan[2].LEDcorrect; } },
+    { "2AI-C",        "2 OK\r\n",  []{ return chan[2].active && chan[2].internal && !chan[2].reverse && chan[2].LEDcorrect; } },
+    { "G13",          "G OK\r\n",  []{ return chan[1].weight == 3; } },
+    { "G19",          "G ERR\r\n", nullptr },
+    { "J10",          "J OK\r\n",  []{ return chan[1].curve == 0; } },
+    { "J19",          "J ERR\r\n", nullptr },
+    { "J12",          "J ERR\r\n", []{ return chan[1].curve == 0; } },   // No RAM tables
+    { "j0100200",     "j OK\r\n",  nullptr },
+    { "j0100300",     "j ERR\r\n", nullptr },
+    { "f1010",        "f OK\r\n",  []{ return chan[1].maxCur == 10; } },
+    { "f1300",        "f ERR\r\n", nullptr },
+    { "q0000",        "q OK\r\n",  nullptr },
+    { "K1",           "K OK\r\n",  nullptr },
+    { "K5",           "K ERR\r\n", nullptr },
+    { "k",            "k OK\r\n",  nullptr },
+    { "U0",           "U OK\r\n",  nullptr },
+    { "U8",           "U ERR\r\n", nullptr },
+    { "u",            "u OK\r\n",  nullptr },
+    { "M001",         "M OK\r\n",  []{ return dmxAddr == 1; } },
+    { "M507",         "M OK\r\n",  []{ return dmxAddr == DMX_ADDR_MAX; } },
+    { "M508",         "M ERR\r\n", nullptr },
+    { "M600",         "M ERR\r\n", nullptr },
+    { "N000",         "N OK\r\n",  nullptr },
+    { "n",            "n OK\r\n",  nullptr },
+    { "D0",           "D OK\r\n",  nullptr },
+    { "E",            "E OK\r\n",  nullptr },
+    { "p",            "p OK\r\n",  nullptr },
+    { "P",            "P OK\r\n",  nullptr },
+    { "w",            "w OK\r\n",  nullptr },
+    { "Y004",         "Y OK\r\n",  nullptr },
+    { "S",            "S OK\r\n",  nullptr },
+    { "X",            "X OK\r\n",  nullptr },
+    { "F",            "F OK\r\n",  nullptr },
+    { "h",            " OK\r\n",   nullptr },
+    { "%",            "% ?\r\n",   nullptr },
+    { "z",            "z ?\r\n",   nullptr },
+};
+
+void test_cmd_table(void)
+{
+    for(const Case &c : Cases) {
+        std::string r = command(c.frame);
+        TEST_ASSERT_TRUE_MESSAGE(endsWith(r, c.reply), c.frame);
+        if(c.effect) TEST_ASSERT_TRUE_MESSAGE(c.effect(), c.frame);
+    }
+}
+
+void test_cmd_help_dmx_bound(void)
+{
+    // Help states the real highest start address
+    std::string r = command("h");
+    TEST_ASSERT_TRUE(r.find("DMX start address (001..507)") != std::string::npos);
+}
+
+void test_cmd_bus_broadcast_silent(void)
+{
+    // Bus node selected by broadcast: commands run, reports and dumps are
+    // skipped, nothing at all is sent
+    command("N001");
+    TEST_ASSERT_EQUAL_STRING("", command("@255").c_str());
+    static const char *Frames[] = { "p", "P", "w", "k", "u", "m", "n", "h", "Y004", "y004", "Z", "V1099" };
+    for(const char *f : Frames) {
+        TEST_ASSERT_EQUAL_STRING_MESSAGE("", command(f).c_str(), f);
+    }
+    TEST_ASSERT_EQUAL_UINT8(99, chan[1].getVal());
+    // Selected individually: reports again
+    TEST_ASSERT_EQUAL_STRING("@ OK\r\n", command("@001").c_str());
+    TEST_ASSERT_TRUE(endsWith(command("n"), "n OK\r\n"));
+    command("N000");
+}
+
+void test_cmd_any_split(void)
+{
+    // A frame split at any point gives the same result as in one piece
+    static const char Frame[] = "T00120000000";
+    for(uint8_t cut = 1; cut < sizeof(Frame) - 1; cut++) {
+        boot();
+        std::string f(Frame);
+        TEST_ASSERT_EQUAL_STRING("", command(f.substr(0, cut)).c_str());
+        TEST_ASSERT_EQUAL_STRING("T OK\r\n", command(f.substr(cut)).c_str());
+    }
+}
+
+void test_cmd_line_ends_ignored(void)
+{
+    TEST_ASSERT_EQUAL_STRING("V OK\r\nA OK\r\n", command("V0\r\n010\r\nA1\n").c_str());
+    TEST_ASSERT_EQUAL_UINT8(10, chan[0].getVal());
+}
+
+void test_cmd_partial_frame_times_out(void)
+{
+    // An incomplete frame is dropped after 10s without chars
+    command("V3");
+    runFor(11000);
+    TEST_ASSERT_EQUAL_STRING("a OK\r\n", command("a3").c_str());
+    TEST_ASSERT_FALSE(chan[3].active);
+}
+
+void test_bench_commands_per_second(void)
+{
+    // Commands/s through Serial and the parser (host time), for a frame
+    // found first in the table, one found last, and a mix
+    const uint32_t N = 20000;
+    static const char *Mix[] = { "V0128", "A1", "G13", "2AI-C", "J10", "K0" };
+    struct Run { const char *name; const char *frames[6]; uint8_t n; } runs[] = {
+        { "cmdFirst", { "V0128" }, 1 },
+        { "cmdLast",  { "K0" }, 1 },
+        { "cmdMix",   { Mix[0], Mix[1], Mix[2], Mix[3], Mix[4], Mix[5] }, 6 },
+    };
+    char buf[80];
+    for(const Run &r : runs) {
+        std::string in;
+        for(uint32_t i = 0; i < N; i++) in += r.frames[i % r.n];
+        Serial.inject(in.c_str());
+        auto t0 = std::chrono::steady_clock::now();
+        processCmds(millis());
+        auto t1 = std::chrono::steady_clock::now();
+        std::string out = Serial.take();
+        double s = std::chrono::duration<double>(t1 - t0).count();
+        TEST_ASSERT_EQUAL_UINT32(0, Serial.available());
+        TEST_ASSERT_TRUE(out.find("ERR") == std::string::npos);
+        snprintf(buf, sizeof(buf), "%s,%.0f cmd/s,%.1f ns/char", r.name,
+                 N / s, s * 1e9 / in.size());
+        TEST_MESSAGE(buf);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_cmd_table);
+    RUN_TEST(test_cmd_help_dmx_bound);
+    RUN_TEST(test_cmd_bus_broadcast_silent);
+    RUN_TEST(test_cmd_any_split);
+    RUN_TEST(test_cmd_line_ends_ignored);
+    RUN_TEST(test_cmd_partial_frame_times_out);
+    RUN_TEST(test_bench_commands_per_second);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// =======================================================================
+// @file        test_main.cpp
+//
+// @project     NanoPWM
+// @details     Host tests: Timer2 software PWM (USE_SOFT_PWM)
+//
+// @author      agent (agent@local) - 2026-10-17
+//
+// Copyright (c) 2026 GiorgioCC
+// =======================================================================
+
+#include <unity.h>
+#include <chrono>
+#include "main.h"
+#include "SoftPwm.h"
+
+// Channels driven in software on the Nano: D3, D11, then D2, D4, D7, D8
+static const uint8_t SoftCh[] = { 0, 5, 6, 7, 8, 9 };
+static const uint8_t NSoft    = sizeof(SoftCh);
+
+static void setDuty(uint8_t ch, uint8_t d)
+{
+    chan[ch].internal   = false;
+    chan[ch].LEDcorrect = false;
+    chan[ch].setVal(d);
+}
+
+// Let the edge list be rebuilt and swapped in by the ISR
+static void settle(void)
+{
+    for(uint8_t i = 0; i < 3; i++) {
+        SoftPwm::update();
+        sim::advance(1024);
+    }
+}
+
+static bool pinHigh(uint8_t pin)
+{
+    return *portOutputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin);
+}
+
+// Timer counts the pin is high, averaged over <periods> PWM periods
+static uint16_t highCounts(uint8_t pin, uint8_t periods)
+{
+    uint32_t n = 0;
+    while(TCNT2 != 0) sim::step();
+    for(uint16_t i = 0; i < 256 * periods; i++) {
+        if(pinHigh(pin)) n++;
+        sim::step();
+    }
+    return (uint16_t)((n + periods / 2) / periods);
+}
+
+// One PWM period, with the ISRs called directly as the timer would:
+// returns the number of interrupts taken
+static uint8_t runPeriod(void)
+{
+    uint8_t irqs = 1;
+    TCNT2 = 0;
+    TIMER2_OVF_vect();
+    while(TIMSK2 & _BV(OCIE2A)) {
+        TCNT2 = OCR2A;
+        TIMER2_COMPA_vect();
+        irqs++;
+    }
+    return irqs;
+}
+
+void setUp(void)
+{
+    for(uint8_t i = 0; i < NSoft; i++) setDuty(SoftCh[i], 0);
+    settle();
+}
+void tearDown(void) {}
+
+void test_softpwm_timer_setup(void)
+{
+    TEST_ASSERT_EQUAL_HEX8(0, TCCR2A);
+    TEST_ASSERT_EQUAL_HEX8(_BV(CS22), TCCR2B);
+    TEST_ASSERT_TRUE(TIMSK2 & _BV(TOIE2));
+}
+
+void test_softpwm_duty(void)
+{
+    // Pulse width = duty, in timer counts; edges closer than 2 counts to
+    // the period start may be up to 2 LSB off
+    static const uint8_t Duty[] = { 3, 10, 64, 128, 200, 254 };
+    for(uint8_t i = 0; i < NSoft; i++) setDuty(SoftCh[i], Duty[i]);
+    settle();
+    for(uint8_t i = 0; i < NSoft; i++) {
+        TEST_ASSERT_UINT_WITHIN(1, Duty[i], highCounts(chan[SoftCh[i]].PWMpin, 4));
+    }
+}
+
+void test_softpwm_full_and_off(void)
+{
+    setDuty(6, 255);
+    setDuty(7, 0);
+    settle();
+    TEST_ASSERT_EQUAL_UINT16(256, highCounts(chan[6].PWMpin, 2));
+    TEST_ASSERT_EQUAL_UINT16(0, highCounts(chan[7].PWMpin, 2));
+}
+
+void test_softpwm_shared_duty_one_edge(void)
+{
+    // Outputs ending on the same count share an interrupt
+    for(uint8_t i = 0; i < NSoft; i++) setDuty(SoftCh[i], 100);
+    settle();
+    TEST_ASSERT_EQUAL_UINT8(2, runPeriod());
+    for(uint8_t i = 0; i < NSoft; i++) TEST_ASSERT_FALSE(pinHigh(chan[SoftCh[i]].PWMpin));
+}
+
+void test_softpwm_changes_coalesced(void)
+{
+    // Several writes before the ISR takes the list: the last one wins
+    setDuty(8, 10);
+    setDuty(8, 50);
+    setDuty(8, 90);
+    settle();
+    TEST_ASSERT_UINT_WITHIN(1, 90, highCounts(chan[8].PWMpin, 2));
+}
+
+void test_bench_isr_cost(void)
+{
+    // ISR work per PWM period as the number of distinct duties grows:
+    // one overflow interrupt, plus one compare interrupt per edge
+    const uint32_t N = 20000;
+    char buf[64];
+    TEST_MESSAGE("softPwmIsr,channels,irqs,ns");
+    for(uint8_t k = 0; k <= NSoft; k++) {
+        for(uint8_t i = 0; i < NSoft; i++) setDuty(SoftCh[i], (i < k) ? 20 + 35 * i : 0);
+        settle();
+        uint8_t irqs = runPeriod();
+        TEST_ASSERT_EQUAL_UINT8(1 + k, irqs);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < N; i++) runPeriod();
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / N;
+        snprintf(buf, sizeof(buf), "softPwmIsr,%u,%u,%.1f", k, irqs, ns);
+        TEST_MESSAGE(buf);
+    }
+}
+
+int main(void)
+{
+    // Soft PWM slots can't be released: boot once for all tests
+    sim::reset();
+    appSetup();
+    Serial.take();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_softpwm_timer_setup);
+    RUN_TEST(test_softpwm_duty);
+    RUN_TEST(test_softpwm_full_and_off);
+    RUN_TEST(test_softpwm_shared_duty_one_edge);
+    RUN_TEST(test_softpwm_changes_coalesced);
+    RUN_TEST(test_bench_isr_cost);
+    return UNITY_END();
+}